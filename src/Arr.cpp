@@ -1,10 +1,18 @@
 #include <array>
+#include <bit>
 #include <rack.hpp>
 #include <unordered_map>
+#include "Bus.hpp"
+#include "HistX.hpp"
 #include "InX.hpp"
+#include "MathX.hpp"
+#include "MidiImport.hpp"
 #include "OutX.hpp"
+#include "PatternLibrary.hpp"
+#include "PatternMemory.hpp"
 #include "ReX.hpp"
 #include "Shared.hpp"
+#include "SortX.hpp"
 #include "biexpander/biexpander.hpp"
 #include "comp/Segment.hpp"
 #include "comp/knobs.hpp"
@@ -29,7 +37,7 @@ struct Arr : public biexpand::Expandable<float> {
         PARAMS_LEN
 
     };
-    enum InputId { INPUTS_LEN };
+    enum InputId { INPUT_PATTERN, INPUTS_LEN };
     enum OutputId { OUTPUT_MAIN, OUTPUTS_LEN };
     enum LightId { LIGHT_LEFT_CONNECTED, LIGHT_RIGHT_CONNECTED, LIGHTS_LEN };
 
@@ -99,22 +107,24 @@ struct Arr : public biexpand::Expandable<float> {
 
         return closestVoltage;
     }
-    struct ArrParamQuantity : ParamQuantity {
+    /// @brief The knobs edit the active pattern on the next sample, see PatternMemory::sync()
+    struct ArrParamQuantity : biexpand::CachedParamQuantity<> {
        public:
         void setValue(float value) override
         {
-            auto* arr = reinterpret_cast<Arr*>(this->module);
+            auto* arr = static_cast<Arr*>(this->module);
             if (arr->snapToQuant) { ParamQuantity::setImmediateValue(arr->quantizeValue(value)); }
             else {
                 ParamQuantity::setValue(value);
             }
+            notifyChange();
             // ParamQuantity::setImmediateValue(dynamic_cast<Arr*>(module)->quantizeValue(value));
         }
 
         // Display the value in the input box
         std::string getDisplayValueString() override
         {
-            const auto* module = reinterpret_cast<const Arr*>(this->module);
+            const auto* module = static_cast<const Arr*>(this->module);
             switch (module->quantTo) {
                 case QuantTo::none: {
                     return string::f("%.3f", ParamQuantity::getValue());
@@ -139,7 +149,7 @@ struct Arr : public biexpand::Expandable<float> {
         // Input D#4 in input box
         void setDisplayValueString(std::string s) override
         {
-            auto* module = reinterpret_cast<Arr*>(this->module);
+            auto* module = static_cast<Arr*>(this->module);
             switch (module->quantTo) {
                 case QuantTo::none: {
                     ParamQuantity::setDisplayValueString(s);
@@ -189,7 +199,7 @@ struct Arr : public biexpand::Expandable<float> {
 
         std::string getString() override
         {
-            const auto* const module = reinterpret_cast<Arr*>(this->module);
+            const auto* const module = static_cast<Arr*>(this->module);
             switch (module->quantTo) {
                 case QuantTo::none: {
                     case QuantTo::wholeVolts:
@@ -228,60 +238,97 @@ struct Arr : public biexpand::Expandable<float> {
     }
     RexAdapter rex;
     InxAdapter inx;
+    SortxAdapter sortx;
+    MathxAdapter mathx;
+    HistxAdapter histx;
     OutxAdapter outx;
+    /// @brief The buffer after the left adapters, as last passed to Out<sup>x</sup>
+    /// @details Lets transformChangedSlots() recompute single elements.
+    std::array<float, constants::MAX_STEPS> chainValues{};
+    bool chainValuesValid = false;
+    /// @brief The crossfaded patterns, used instead of the knobs while morphing
+    std::array<float, constants::MAX_STEPS> morphValues{};
+    /// @brief The knobs edit the active pattern
+    PatternMemory<float> patterns;
+    /// @brief Number of stored patterns the pattern CV morphs across, 0 to select patterns
+    int morphPatterns = 0;
+    /// @brief Morph position the buffer was last computed at, 0 to 1. Negative forces a refresh.
+    float morphPosition = -1.F;
+    /// @brief Smaller morph CV moves (relative to 0V-10V) leave the buffer alone
+    static constexpr float MORPH_THRESHOLD = 0.001F;
 
     constants::VoltageRange voltageRange{constants::ZERO_TO_TEN};
     float minVoltage = 0.0F;
     float maxVoltage = 10.0F;
+    bus::Sender busOut;
+    /// @brief While a library is loaded the pattern select CV picks one of its records
+    patlib::Library library{patlib::Type::VOLTAGES};
+    midiimport::Importer importer;
 
    public:
     Arr()
-        : biexpand::Expandable<float>({{modelReX, &this->rex}, {modelInX, &this->inx}},
-                                      {{modelOutX, &this->outx}})
+        : biexpand::Expandable<float>(
+              {{modelReX, &this->rex},
+               {modelInX, &this->inx},
+               {modelSortX, &this->sortx},
+               {modelMathX, &this->mathx},
+               {modelHistX, &this->histx}},
+              {{modelOutX, &this->outx}})
     {
         config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
         for (int i = 0; i < constants::NUM_CHANNELS; i++) {
             configParam<ArrParamQuantity>(PARAM_KNOB + i, 0.0F, 10.F, 0.0F, "", "V");
         }
-        configCache();
+        configInput(INPUT_PATTERN, "Pattern select");
+        configCache({INPUT_PATTERN});
     }
     void performTransforms(bool forced = false)  // 95% same as Bank
     {
-        bool changed = readVoltages(forced);
+        forced |= library.pick(inputs[INPUT_PATTERN]);
+        if (!library.getMapping()) {
+            forced |= switchPattern();
+            forced |= moveMorph();
+        }
+        const bool changed = this->cacheState.needsRefreshing();
+        const uint16_t edited = changed || forced ? patterns.sync(&params[PARAM_KNOB]) : 0;
         bool dirtyAdapters = false;
         if (!changed && !forced) { dirtyAdapters = this->dirtyAdapters(); }
-        // Update our buffer because an adapter is dirty and our buffer needs to be updated
-        if (!changed && !forced && dirtyAdapters) { readVoltages(true); }
-
-        if (changed || dirtyAdapters || forced) {
-            for (biexpand::Adapter* adapter : getLeftAdapters()) {
-                transform(*adapter);
-            }
-
-            // Segment should reflex input changes but not output changes
-            cachedBufferSize = readBuffer().size();
-
-            if (outx) { outx.write(readBuffer().begin(), readBuffer().end()); }
-            for (biexpand::Adapter* adapter : getRightAdapters()) {
-                transform(*adapter);
-            }
-            writeVoltages();
+        if (!changed && !dirtyAdapters && !forced) {
+            publishBus(false);
+            return;
         }
+        if (!forced && transformChangedSlots(edited)) {
+            publishBus(true);
+            return;
+        }
+        readVoltages(true);
+        transformLeftAdapters();
+
+        // Segment should reflex input changes but not output changes
+        cachedBufferSize = readBuffer().size();
+        std::copy(readBuffer().begin(), readBuffer().end(), chainValues.begin());
+        chainValuesValid = true;
+
+        if (outx) { outx.write(readBuffer().begin(), readBuffer().end()); }
+        transformRightAdapters();
+        writeVoltages();
+        publishBus(true);
     }
     void onUpdateExpanders(bool /*isRight*/) override
     {
-        // if it is inx, pass a lambda to quantize
-        if (inx) {
-            if (this->quantTo == QuantTo::none) { inx.setFloatValueFunction(nullptr); }
-            else {
-                inx.setFloatValueFunction([this](float value) { return quantizeValue(value); });
-            }
+        // if it is inx or mathx, pass a lambda to quantize
+        std::function<float(float)> quantize = nullptr;
+        if (this->quantTo != QuantTo::none) {
+            quantize = [this](float value) { return quantizeValue(value); };
         }
+        if (inx) { inx.setFloatValueFunction(quantize); }
+        if (mathx) { mathx.setFloatValueFunction(quantize); }
         performTransforms(true);
     }
     void process(const ProcessArgs& /*args*/) override
     {
-        performTransforms();
+        resolvePendingChain();
+        performTransforms(importPatterns());
     }
 
     QuantTo getQuantTo() const
@@ -314,6 +361,15 @@ struct Arr : public biexpand::Expandable<float> {
         minVoltage = voltageRangeMinMax[range].second.first;
         maxVoltage = voltageRangeMinMax[range].second.second;
 
+        // Stored patterns keep their position relative to the range as well
+        const float oldMin = getParamQuantity(PARAM_KNOB)->minValue;
+        const float oldMax = getParamQuantity(PARAM_KNOB)->maxValue;
+        for (int pattern = 0; pattern < constants::NUM_PATTERNS; pattern++) {
+            for (float* value = patterns.pattern(pattern);
+                 value != patterns.pattern(pattern) + constants::MAX_STEPS; ++value) {
+                *value = rescale(*value, oldMin, oldMax, minVoltage, maxVoltage);
+            }
+        }
         // This bit reads the relative values of the knobs and scales them to the new range
         for (int i = PARAM_KNOB; i < PARAM_KNOB + constants::NUM_CHANNELS; i++) {
             const float old_value = getParam(i).getValue();
@@ -353,6 +409,30 @@ struct Arr : public biexpand::Expandable<float> {
         }
     }
 
+    int getPattern() const
+    {
+        return patterns.getSelected();
+    }
+    void setPattern(int pattern)
+    {
+        patterns.setSelected(pattern);
+    }
+    int getMorphPatterns() const
+    {
+        return morphPatterns;
+    }
+    void setMorphPatterns(int count)
+    {
+        morphPatterns = count;
+        morphPosition = -1.F;
+    }
+
+    void onReset() override
+    {
+        patterns.clear();
+        patterns.setSelected(0);
+    }
+
     void onRandomize() override
     {
         for (int param_id = PARAM_KNOB; param_id < PARAM_KNOB + 16; param_id++) {
@@ -370,6 +450,11 @@ struct Arr : public biexpand::Expandable<float> {
         json_object_set_new(rootJ, "rootNote", json_integer(rootNote));
         json_object_set_new(rootJ, "numerator", json_integer(numerator));
         json_object_set_new(rootJ, "denominator", json_integer(denominator));
+        json_object_set_new(rootJ, "pattern", json_integer(patterns.getSelected()));
+        json_object_set_new(rootJ, "patterns", patterns.toJson());
+        json_object_set_new(rootJ, "morphPatterns", json_integer(morphPatterns));
+        json_object_set_new(rootJ, "sendBus", json_integer(busOut.getSelected()));
+        json_object_set_new(rootJ, "library", json_string(library.getPath().c_str()));
         for (int i = 0; i < constants::NUM_CHANNELS; i++) {
             json_object_set_new(rootJ, ("knob" + std::to_string(i)).c_str(),
                                 json_real(getParam(PARAM_KNOB + i).getValue()));
@@ -402,18 +487,164 @@ struct Arr : public biexpand::Expandable<float> {
             json_t* knobJ = json_object_get(rootJ, ("knob" + std::to_string(i)).c_str());
             if (knobJ) { getParam(PARAM_KNOB + i).setValue(json_real_value(knobJ)); }
         }
+        json_t* patternJ = json_object_get(rootJ, "pattern");
+        if (patternJ) { patterns.setSelected(json_integer_value(patternJ)); }
+        // Without stored patterns, as in older patches, the knobs are the active pattern
+        patterns.clear();
+        json_t* patternsJ = json_object_get(rootJ, "patterns");
+        if (patternsJ) { patterns.fromJson(patternsJ); }
+        else {
+            std::copy(ParamIterator{params.begin()}, ParamIterator{params.end()},
+                      patterns.active());
+        }
+        json_t* morphPatternsJ = json_object_get(rootJ, "morphPatterns");
+        if (morphPatternsJ) { setMorphPatterns(json_integer_value(morphPatternsJ)); }
+        json_t* sendBusJ = json_object_get(rootJ, "sendBus");
+        if (sendBusJ) { busOut.select(json_integer_value(sendBusJ)); }
+        json_t* libraryJ = json_object_get(rootJ, "library");
+        if (libraryJ && json_string_length(libraryJ) > 0) {
+            // A library that moved is left out, the patterns still work
+            std::string error;
+            library.load(json_string_value(libraryJ), error);
+        }
     }
 
    private:
+    /// @brief Recomputes only the elements affected by edited steps or expander ports
+    /// @details Works when every adapter can map changed indices (see Adapter::mapDirty()) and
+    /// the lengths stay the same. Otherwise returns false and the whole chain is transformed.
+    /// @param edited The steps edited through the knobs, see PatternMemory::sync()
+    bool transformChangedSlots(uint16_t edited)
+    {
+        if (!chainValuesValid || !canQueryChain() || (outx && !outx.canQuery())) { return false; }
+        const uint16_t changedKnobs = edited | cacheState.getChangedParams();
+        readVoltages(true);
+        const uint16_t dirty = mapDirtyChain(changedKnobs, 0);
+        const int length = queryChainLength(0);
+        if (dirty == ALL_INDICES || length != cachedBufferSize) { return false; }
+        for (uint16_t mask = dirty & ((1U << length) - 1U); mask; mask &= mask - 1) {
+            const int index = std::countr_zero(mask);
+            chainValues[index] = queryChain(index, 0);
+        }
+        refreshLeftAdapters();
+
+        uint16_t dirtyOut = dirty;
+        int outLength = length;
+        if (outx) {
+            outx.writeChanged(chainValues.begin(), chainValues.begin() + length, dirty);
+            dirtyOut = outx.mapDirty(dirty, length, 0);
+            outLength = outx.queryLength(length, 0);
+            outx.needsRefresh();
+            outx.refresh();
+            if (dirtyOut == ALL_INDICES || outLength != outputs[OUTPUT_MAIN].getChannels()) {
+                return false;
+            }
+        }
+        const bool quantize = quantTo != QuantTo::none && !snapToQuant;
+        for (uint16_t mask = dirtyOut & ((1U << outLength) - 1U); mask; mask &= mask - 1) {
+            const int index = std::countr_zero(mask);
+            const float value = chainValues[outx ? outx.querySource(index, length, 0) : index];
+            outputs[OUTPUT_MAIN].setVoltage(quantize ? quantizeValue(value) : value, index);
+        }
+        return true;
+    }
+
     bool readVoltages(bool forced = false)
     {
         const bool changed = this->cacheState.needsRefreshing();
         if (changed || forced) {
-            readBuffer().assign(ParamIterator{params.begin()}, ParamIterator{params.end()});
+            if (library.getMapping()) { readRecord(); }
+            else if (morphPatterns) {
+                morph();
+                readBuffer().assign(morphValues.begin(), morphValues.end());
+            }
+            else {
+                readBuffer().assign(patterns.active(), patterns.active() + constants::MAX_STEPS);
+            }
             cacheState.refresh();
         }
         return changed;
     }
+    /// @brief Reads the picked record straight from the mapping into the buffer
+    void readRecord()
+    {
+        const patlib::VoltageRecord& record =
+            library.getMapping()->voltages(library.getRecord());
+        const int length = std::min<int>(record.length, constants::MAX_STEPS);
+        readBuffer().assign(record.values.begin(), record.values.begin() + length);
+        // As when morphing, the values don't come from the (snapping) knobs
+        if (quantTo != QuantTo::none) {
+            for (auto& v : readBuffer()) {
+                v = quantizeValue(v);
+            }
+        }
+    }
+    /// @brief Makes the pattern picked by the pattern select CV (or menu) the active one
+    /// @details The knobs follow in the same sample, see PatternMemory::sync().
+    bool switchPattern()
+    {
+        // While morphing the knobs stay on the pattern picked in the menu
+        return morphPatterns ? patterns.activate(patterns.getSelected())
+                             : patterns.process(inputs[INPUT_PATTERN]);
+    }
+    /// @brief Copies the pitches of a finished MIDI import into the stored patterns
+    /// @details The imported patterns replace the selected pattern and the ones after it. Pitches
+    /// are clamped to the voltage range.
+    /// @return true when patterns were imported
+    bool importPatterns()
+    {
+        const midiimport::Table* table = importer.acquire();
+        if (!table) { return false; }
+        const int first = patterns.getSelected();
+        const int count = std::min(table->count, constants::NUM_PATTERNS - first);
+        for (int index = 0; index < count; ++index) {
+            const float* pitches = table->pitchPattern(index);
+            std::transform(pitches, pitches + constants::MAX_STEPS, patterns.pattern(first + index),
+                           [this](float pitch) { return clamp(pitch, minVoltage, maxVoltage); });
+        }
+        importer.release(table);
+        return true;
+    }
+    /// @brief Follows the morph CV at the pattern input
+    /// @return true when it moved far enough to recompute the buffer (or morphing was toggled)
+    bool moveMorph()
+    {
+        if (!morphPatterns) { return std::exchange(morphPosition, 0.F) < 0.F; }
+        const float position = clamp(inputs[INPUT_PATTERN].getVoltage() / 10.F, 0.F, 1.F);
+        if (std::abs(position - morphPosition) < MORPH_THRESHOLD) { return false; }
+        morphPosition = position;
+        return true;
+    }
+    /// @brief Crossfades the two neighbouring patterns at morphPosition into morphValues
+    /// @details Starts at the selected pattern. Lerps four slots at a time and quantizes them
+    /// in the same pass, as in-between values are off the scale even when the knobs snap.
+    void morph()
+    {
+        const float position = morphPosition * static_cast<float>(morphPatterns - 1);
+        const int from = std::min(static_cast<int>(position), morphPatterns - 2);
+        const simd::float_4 fraction = position - static_cast<float>(from);
+        const int first = patterns.getSelected() + from;
+        const float* fromPattern = patterns.pattern(first % constants::NUM_PATTERNS);
+        const float* toPattern = patterns.pattern((first + 1) % constants::NUM_PATTERNS);
+        const bool quantize = quantTo != QuantTo::none;
+        for (int i = 0; i < constants::MAX_STEPS; i += 4) {
+            const simd::float_4 a = simd::float_4::load(fromPattern + i);
+            simd::float_4 value = a + (simd::float_4::load(toPattern + i) - a) * fraction;
+            if (quantize) {
+                for (int lane = 0; lane < 4; lane++) {
+                    value[lane] = quantizeValue(value[lane]);
+                }
+            }
+            value.store(morphValues.data() + i);
+        }
+    }
+
+    /// @brief Sends the output, as quantized, to the selected bus
+    void publishBus(bool changed)
+    {
+        Output& output = outputs[OUTPUT_MAIN];
+        busOut.publish(output.getVoltages(), output.getVoltages() + output.getChannels(), changed);
+    }
 
     void writeVoltages()
     {
@@ -456,10 +687,18 @@ struct ArrWidget : public SIMWidget {
                     Arr::PARAM_KNOB + (i * 8) + j));
             }
         }
+        addInput(createInputCentered<comp::SIMPort>(mm2px(Vec(HP, LOW_ROW + JACKYSPACE - 9.F)),
+                                                    module, Arr::INPUT_PATTERN));
         addChild(createOutputCentered<comp::SIMPort>(mm2px(Vec(3 * HP, LOW_ROW + JACKYSPACE - 9.F)),
                                                      module, Arr::OUTPUT_MAIN));
     }
 
+    void step() override
+    {
+        if (auto* module = dynamic_cast<Arr*>(this->module)) { module->importer.poll(); }
+        SIMWidget::step();
+    }
+
     void appendContextMenu(Menu* menu) override  // NOLINT
     {
         auto* module = dynamic_cast<Arr*>(this->module);
@@ -471,6 +710,36 @@ struct ArrWidget : public SIMWidget {
         menu->addChild(module->createExpandableSubmenu(this));
         menu->addChild(new MenuSeparator);
 
+        menu->addChild(
+            createPatternMenuItem([module]() { return module->getPattern(); },
+                                  [module](int pattern) { module->setPattern(pattern); }));
+        std::vector<std::pair<std::string, int>> morphLabels = {
+            {"Off", 0},        {"2 patterns", 2}, {"3 patterns", 3},
+            {"4 patterns", 4}, {"8 patterns", 8}, {"16 patterns", 16}};
+        menu->addChild(createSubmenuItem(
+            "Morph",
+            [module, morphLabels]() -> std::string {
+                for (const auto& pair : morphLabels) {
+                    if (pair.second ==
+                        module->getMorphPatterns()) {  // cppcheck-suppress useStlAlgorithm
+                        return pair.first;
+                    }
+                }
+                return {};
+            }(),
+            [module, morphLabels](rack::Menu* menu) -> void {
+                for (const auto& pair : morphLabels) {
+                    menu->addChild(createMenuItem(
+                        pair.first, (pair.second == module->getMorphPatterns()) ? "✔" : "",
+                        [module, count = pair.second]() { module->setMorphPatterns(count); }));
+                }
+            }));
+        menu->addChild(bus::createMenuItem(
+            "Send to bus", [module]() { return module->busOut.getSelected(); },
+            [module](int index) { module->busOut.select(index); }));
+        menu->addChild(patlib::createLibraryMenuItem(module->library));
+        menu->addChild(midiimport::createImportMenuItem(module->importer));
+
         std::vector<std::pair<std::string, constants::VoltageRange>> voltageRangeLabels = {
             {"0V-10V", constants::ZERO_TO_TEN},         {"0V-5V", constants::ZERO_TO_FIVE},
             {"0V-3V", constants::ZERO_TO_THREE},        {"0V-1V", constants::ZERO_TO_ONE},
@@ -1,6 +1,13 @@
 #include <array>
+#include <atomic>
+#include "BeatX.hpp"
+#include "HistX.hpp"
 #include "InX.hpp"
+#include "LogX.hpp"
+#include "MidiImport.hpp"
 #include "OutX.hpp"
+#include "PatternLibrary.hpp"
+#include "PatternMemory.hpp"
 #include "ReX.hpp"
 #include "biexpander/biexpander.hpp"
 #include "comp/Segment.hpp"
@@ -14,7 +21,7 @@ using iters::ParamIterator;
 struct Bank : biexpand::Expandable<bool> {
    public:
     enum ParamId { ENUMS(PARAM_BOOL, MAX_STEPS), PARAMS_LEN };
-    enum InputId { INPUTS_LEN };
+    enum InputId { INPUT_PATTERN, INPUTS_LEN };
     enum OutputId { OUTPUT_MAIN, OUTPUTS_LEN };
     enum LightId {
 
@@ -36,15 +43,68 @@ struct Bank : biexpand::Expandable<bool> {
     std::array<bool, MAX_STEPS> bitMemory{};
     dsp::ClockDivider uiDivider;
 
+    /// @brief The buttons edit the active pattern
+    PatternMemory<bool> patterns;
+    /// @brief The buffer after the expanders, read by Log<sup>x</sup> of other Banks
+    std::atomic<logx::Gates> gates{0};
+    /// @brief While a library is loaded the pattern select CV picks one of its records
+    patlib::Library library{patlib::Type::GATES};
+    midiimport::Importer importer;
+
     bool readVoltages(bool forced = false)  // 100% same as Arr
     {
         const bool changed = this->cacheState.needsRefreshing();
         if (changed || forced) {
-            readBuffer().assign(ParamIterator{params.begin()}, ParamIterator{params.end()});
+            patterns.sync(&params[PARAM_BOOL]);
+            if (library.getMapping()) { readRecord(); }
+            else {
+                readBuffer().assign(patterns.active(), patterns.active() + MAX_STEPS);
+            }
             cacheState.refresh();
         }
         return changed;
     }
+    /// @brief Unpacks the mask of the picked record straight from the mapping into the buffer
+    void readRecord()
+    {
+        const patlib::GateRecord& record = library.getMapping()->gates(library.getRecord());
+        const int size = std::min<int>(record.length, MAX_STEPS);
+        readBuffer().clear();
+        for (int i = 0; i < size; ++i) {
+            readBuffer().push_back(((record.mask >> i) & 1U) != 0);
+        }
+    }
+    /// @brief Makes the pattern picked by the pattern select CV (or menu) the active one
+    /// @details The buttons follow in the same sample, see PatternMemory::sync().
+    bool switchPattern()
+    {
+        return patterns.process(inputs[INPUT_PATTERN]);
+    }
+    /// @brief Copies the gates of a finished MIDI import into the stored patterns
+    /// @details The imported patterns replace the selected pattern and the ones after it.
+    /// @return true when patterns were imported
+    bool importPatterns()
+    {
+        const midiimport::Table* table = importer.acquire();
+        if (!table) { return false; }
+        const int first = patterns.getSelected();
+        const int count = std::min(table->count, constants::NUM_PATTERNS - first);
+        for (int index = 0; index < count; ++index) {
+            std::copy_n(table->gatePattern(index), MAX_STEPS, patterns.pattern(first + index));
+        }
+        importer.release(table);
+        return true;
+    }
+
+    void publishGates()
+    {
+        uint16_t mask = 0;
+        const int size = readBuffer().size();
+        for (int i = 0; i < size; ++i) {
+            if (readBuffer()[i]) { mask |= 1U << i; }
+        }
+        gates.store(logx::pack(size, mask), std::memory_order_relaxed);
+    }
 
     void writeVoltages()
     {
@@ -57,23 +117,30 @@ struct Bank : biexpand::Expandable<bool> {
     }
 
    public:
-    struct BankParamQuantity : ParamQuantity {
+    /// @brief The buttons edit the active pattern on the next sample, see PatternMemory::sync()
+    struct BankParamQuantity : biexpand::CachedParamQuantity<> {
         std::string getString() override
         {
             return ParamQuantity::getValue() > constants::BOOL_TRESHOLD ? "On" : "Off";
         };
     };
     Bank()
-        : biexpand::Expandable<bool>({{modelReX, &this->rex}, {modelInX, &this->inx}},
-                                     {{modelOutX, &this->outx}})
+        : biexpand::Expandable<bool>(
+              {{modelReX, &this->rex},
+               {modelInX, &this->inx},
+               {modelBeatX, &this->beatx},
+               {modelLogX, &this->logx},
+               {modelHistX, &this->histx}},
+              {{modelOutX, &this->outx}})
     {
         config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
         configOutput(OUTPUT_MAIN, "Main Output");
+        configInput(INPUT_PATTERN, "Pattern select");
         for (int i = 0; i < MAX_STEPS; i++) {
             configParam<BankParamQuantity>(PARAM_BOOL + i, 0.0F, 1.0F, 0.0F,
                                            "Value " + std::to_string(i + 1));
         }
-        configCache();
+        configCache({INPUT_PATTERN});
         uiDivider.setDivision(constants::UI_UPDATE_DIVIDER);
 
         bitMemory.fill(false);
@@ -82,10 +149,14 @@ struct Bank : biexpand::Expandable<bool> {
     void onReset() override
     {
         bitMemory.fill(false);
+        patterns.clear();
+        patterns.setSelected(0);
     }
 
     void performTransforms(bool forced = false)  // 100% same as Bank
     {
+        forced |= library.pick(inputs[INPUT_PATTERN]);
+        if (!library.getMapping()) { forced |= switchPattern(); }
         bool changed = readVoltages(forced);
         bool dirtyAdapters = false;
         if (!changed && !forced) { dirtyAdapters = this->dirtyAdapters(); }
@@ -93,14 +164,11 @@ struct Bank : biexpand::Expandable<bool> {
         if (!changed && !forced && dirtyAdapters) { readVoltages(true); }
 
         if (changed || dirtyAdapters || forced) {
-            for (biexpand::Adapter* adapter : getLeftAdapters()) {
-                transform(*adapter);
-            }
+            transformLeftAdapters();
             if (outx) { outx.write(readBuffer().begin(), readBuffer().end(), maxVoltage); }
-            for (biexpand::Adapter* adapter : getRightAdapters()) {
-                transform(*adapter);
-            }
+            transformRightAdapters();
             writeVoltages();
+            publishGates();
         }
     }
     void onUpdateExpanders(bool /*isRight*/) override
@@ -116,15 +184,13 @@ struct Bank : biexpand::Expandable<bool> {
     {
         return bitMemory[index];
     }
-    void paramToMem()
+    void patternToMem()
     {
-        for (int i = 0; i < MAX_STEPS; i++) {
-            setBool(i, params[PARAM_BOOL + i].getValue() > 0.F);
-        }
+        std::copy_n(patterns.active(), MAX_STEPS, bitMemory.begin());
     }
     void updateUi()  // SPIKE LIKENESS
     {
-        paramToMem();
+        patternToMem();
         std::array<float, MAX_STEPS> brightnesses{};
         start = rex.getStart();
         length = readBuffer().size();
@@ -147,10 +213,25 @@ struct Bank : biexpand::Expandable<bool> {
 
     void process(const ProcessArgs& /*args*/) override
     {
-        performTransforms();
+        resolvePendingChain();
+        performTransforms(importPatterns());
         if (uiDivider.process()) { updateUi(); }
     }
 
+    logx::Gates getGates() const
+    {
+        return gates.load(std::memory_order_relaxed);
+    }
+
+    int getPattern() const
+    {
+        return patterns.getSelected();
+    }
+    void setPattern(int pattern)
+    {
+        patterns.setSelected(pattern);
+    }
+
     int getVoltageRange() const
     {
         return voltageRange;
@@ -199,6 +280,9 @@ struct Bank : biexpand::Expandable<bool> {
     {
         json_t* rootJ = json_object();
         json_object_set_new(rootJ, "voltageRange", json_integer(static_cast<int>(voltageRange)));
+        json_object_set_new(rootJ, "pattern", json_integer(patterns.getSelected()));
+        json_object_set_new(rootJ, "patterns", patterns.toJson());
+        json_object_set_new(rootJ, "library", json_string(library.getPath().c_str()));
         return rootJ;
     }
 
@@ -209,12 +293,31 @@ struct Bank : biexpand::Expandable<bool> {
             setVoltageRange(
                 static_cast<constants::VoltageRange>(json_integer_value(voltageRangeJ)));
         }
+        json_t* patternJ = json_object_get(rootJ, "pattern");
+        if (patternJ) { patterns.setSelected(json_integer_value(patternJ)); }
+        // Without stored patterns, as in older patches, the buttons are the active pattern
+        patterns.clear();
+        json_t* patternsJ = json_object_get(rootJ, "patterns");
+        if (patternsJ) { patterns.fromJson(patternsJ); }
+        else {
+            std::transform(ParamIterator{params.begin()}, ParamIterator{params.end()},
+                           patterns.active(), [](float value) { return value > 0.F; });
+        }
+        json_t* libraryJ = json_object_get(rootJ, "library");
+        if (libraryJ && json_string_length(libraryJ) > 0) {
+            // A library that moved is left out, the patterns still work
+            std::string error;
+            library.load(json_string_value(libraryJ), error);
+        }
     }
 
    private:
     friend struct BankWidget;
     RexAdapter rex;
     InxAdapter inx;
+    BeatxAdapter beatx;
+    LogxAdapter logx;
+    HistxAdapter histx;
     OutxAdapter outx;
 };
 
@@ -245,10 +348,18 @@ struct BankWidget : public SIMWidget {
                         module, Bank::PARAM_BOOL + (j + i * 8), Bank::LIGHTS_BOOL + (j + i * 8)));
             }
         }
+        addInput(createInputCentered<comp::SIMPort>(mm2px(Vec(HP, LOW_ROW + JACKYSPACE - 9.F)),
+                                                    module, Bank::INPUT_PATTERN));
         addOutput(createOutputCentered<comp::SIMPort>(
             mm2px(Vec(3 * HP, LOW_ROW + JACKYSPACE - 9.F)), module, Bank::OUTPUT_MAIN));
     }
 
+    void step() override
+    {
+        if (auto* module = dynamic_cast<Bank*>(this->module)) { module->importer.poll(); }
+        SIMWidget::step();
+    }
+
     void appendContextMenu(Menu* menu) override
     {
         SIMWidget::appendContextMenu(menu);
@@ -260,6 +371,12 @@ struct BankWidget : public SIMWidget {
         menu->addChild(module->createExpandableSubmenu(this));
         menu->addChild(new MenuSeparator);  // NOLINT
 
+        menu->addChild(
+            createPatternMenuItem([module]() { return module->getPattern(); },
+                                  [module](int pattern) { module->setPattern(pattern); }));
+        menu->addChild(patlib::createLibraryMenuItem(module->library));
+        menu->addChild(midiimport::createImportMenuItem(module->importer));
+
         std::vector<std::string> voltageRangeLabels = {"0V-10V", "0V-5V", "0V-3V", "0V-1V"};
         menu->addChild(createIndexSubmenuItem(
             "Voltage Range", voltageRangeLabels, [module]() { return module->getVoltageRange(); },
@@ -269,4 +386,9 @@ struct BankWidget : public SIMWidget {
     }
 };
 
+logx::Gates logx::bankGates(const Module& bank)
+{
+    return static_cast<const Bank&>(bank).getGates();
+}
+
 Model* modelBank = createModel<Bank, BankWidget>("Bank");  // NOLINT
\ No newline at end of file
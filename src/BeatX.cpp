@@ -0,0 +1,76 @@
+#include "BeatX.hpp"
+#include "comp/knobs.hpp"
+#include "comp/ports.hpp"
+#include "constants.hpp"
+#include "plugin.hpp"
+
+BeatX::BeatX() : biexpand::BiExpander(false)
+{
+    config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+
+    configParam<biexpand::CachedParamQuantity<>>(PARAM_HITS, 0.0F, 16.0F, 4.0F, "Hits");
+    configParam<biexpand::CachedParamQuantity<>>(PARAM_LENGTH, 1.0F, 16.0F, 16.0F, "Length");
+    configParam<biexpand::CachedParamQuantity<>>(PARAM_ROTATION, 0.0F, 15.0F, 0.0F, "Rotation");
+    configSwitch<biexpand::CachedParamQuantity<SwitchQuantity>>(PARAM_MODE, 0.0F, 1.0F, 0.0F,
+                                                                "Mode", {"Euclidean", "Necklace"});
+
+    getParamQuantity(PARAM_HITS)->snapEnabled = true;
+    getParamQuantity(PARAM_LENGTH)->snapEnabled = true;
+    getParamQuantity(PARAM_ROTATION)->snapEnabled = true;
+    configInput(INPUT_HITS, "Hits CV");
+    configInput(INPUT_LENGTH, "Length CV");
+    configInput(INPUT_ROTATION, "Rotation CV");
+    configCache();
+    // Build the necklace table here rather than on the audio thread
+    beatx::Necklaces::get();
+};
+
+using namespace dimensions;  // NOLINT
+struct BeatXWidget : public SIMWidget {
+    explicit BeatXWidget(BeatX* module)
+    {
+        const float center = 1.F * HP;
+        setModule(module);
+        setSIMPanel("BeatX");
+
+        if (module) {
+            module->connectionLights.addDefaultConnectionLights(this, -1,
+                                                                BeatX::LIGHT_RIGHT_CONNECTED);
+        }
+
+        addParam(createParamCentered<comp::SIMKnob>(
+            mm2px(Vec(center, JACKYSTART + 0 * PARAMJACKNTXT)), module, BeatX::PARAM_HITS));
+        addInput(createInputCentered<comp::SIMPort>(
+            mm2px(Vec(center, JACKYSTART + 0 * PARAMJACKNTXT + JACKYSPACE)), module,
+            BeatX::INPUT_HITS));
+
+        addParam(createParamCentered<comp::SIMKnob>(
+            mm2px(Vec(center, JACKYSTART + 1 * PARAMJACKNTXT)), module, BeatX::PARAM_LENGTH));
+        addInput(createInputCentered<comp::SIMPort>(
+            mm2px(Vec(center, JACKYSTART + 1 * PARAMJACKNTXT + JACKYSPACE)), module,
+            BeatX::INPUT_LENGTH));
+
+        addParam(createParamCentered<comp::SIMKnob>(
+            mm2px(Vec(center, JACKYSTART + 2 * PARAMJACKNTXT)), module, BeatX::PARAM_ROTATION));
+        addInput(createInputCentered<comp::SIMPort>(
+            mm2px(Vec(center, JACKYSTART + 2 * PARAMJACKNTXT + JACKYSPACE)), module,
+            BeatX::INPUT_ROTATION));
+    }
+
+    void appendContextMenu(Menu* menu) override
+    {
+        auto* module = dynamic_cast<BeatX*>(this->module);
+        assert(module);  // NOLINT
+
+        menu->addChild(createIndexSubmenuItem(
+            "Mode", {"Euclidean", "Necklace (rot. picks the necklace)"},
+            [module]() {
+                return static_cast<size_t>(module->params[BeatX::PARAM_MODE].getValue());
+            },
+            [module](size_t mode) {
+                module->params[BeatX::PARAM_MODE].setValue(static_cast<float>(mode));
+            }));
+        SIMWidget::appendContextMenu(menu);
+    }
+};
+Model* modelBeatX = createModel<BeatX, BeatXWidget>("BeatX");  // NOLINT
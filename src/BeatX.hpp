@@ -0,0 +1,231 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <rack.hpp>
+#include <vector>
+#include "biexpander/biexpander.hpp"
+#include "constants.hpp"
+#include "helpers/iters.hpp"
+
+using namespace rack;  // NOLINT
+
+struct BeatX : public biexpand::BiExpander {
+    enum ParamId { PARAM_HITS, PARAM_LENGTH, PARAM_ROTATION, PARAM_MODE, PARAMS_LEN };
+    enum InputId { INPUT_HITS, INPUT_LENGTH, INPUT_ROTATION, INPUTS_LEN };
+    enum OutputId { OUTPUTS_LEN };
+    enum LightId { LIGHT_RIGHT_CONNECTED, LIGHTS_LEN };
+    enum class Mode { EUCLIDEAN, NECKLACE };
+    BeatX();
+};
+
+namespace beatx {
+/// @brief Bit i of a rhythm is step i, steps beyond the length are 0
+inline constexpr uint16_t lengthMask(int length)
+{
+    return static_cast<uint16_t>((1U << length) - 1U);
+}
+/// @brief The Euclidean rhythm of hits in length steps, starting with a hit
+/// @details Step i is a hit when (i * hits) mod length < hits, the Bresenham form of Bjorklund's
+/// algorithm, which needs no recursion.
+inline constexpr uint16_t euclid(int hits, int length)
+{
+    if (hits >= length) { return lengthMask(length); }
+    uint16_t mask = 0;
+    for (int i = 0; i < length; ++i) {
+        if ((i * hits) % length < hits) { mask |= 1U << i; }
+    }
+    return mask;
+}
+/// @brief Starts the rhythm at step rotation, as Re<sup>x</sup> does with start
+inline constexpr uint16_t rotate(uint16_t mask, int rotation, int length)
+{
+    if (rotation == 0) { return mask; }
+    return static_cast<uint16_t>(((mask >> rotation) | (mask << (length - rotation))) &
+                                 lengthMask(length));
+}
+
+/// @brief All binary necklaces (rhythms up to rotation) by length and number of hits
+/// @details Each necklace is stored as its rotation that is largest when read from step 0, so
+/// that it starts with a hit. Ordered as read from step 0, descending, so the first necklace
+/// has all hits at the start.
+/// Built once, on first use from the UI thread (see BeatX::BeatX()).
+class Necklaces {
+   public:
+    static const Necklaces& get()
+    {
+        static const Necklaces necklaces;
+        return necklaces;
+    }
+    const std::vector<uint16_t>& of(int hits, int length) const
+    {
+        return table[length][hits];
+    }
+
+   private:
+    std::array<std::array<std::vector<uint16_t>, constants::MAX_STEPS + 1>,
+               constants::MAX_STEPS + 1>
+        table;
+    Necklaces()
+    {
+        for (int length = 1; length <= constants::MAX_STEPS; ++length) {
+            // word has step 0 in its highest bit, so numeric order is the order read from step 0
+            for (uint32_t word = 1U << length; word-- > 0;) {
+                if (!isLargestRotation(word, length)) { continue; }
+                uint16_t mask = 0;
+                for (int i = 0; i < length; ++i) {
+                    if (word & (1U << (length - 1 - i))) { mask |= 1U << i; }
+                }
+                table[length][std::popcount(word)].push_back(mask);
+            }
+        }
+    }
+    static bool isLargestRotation(uint32_t word, int length)
+    {
+        for (int shift = 1; shift < length; ++shift) {
+            const uint32_t rotated = ((word << shift) | (word >> (length - shift))) &
+                                     ((1U << length) - 1U);
+            if (rotated > word) { return false; }
+        }
+        return true;
+    }
+};
+}  // namespace beatx
+
+/// @brief Replaces the gate buffer with a generated rhythm
+/// @details The rhythm is kept as a 16 bit mask per channel and only rebuilt (and reported as a
+/// change to the host) when hits, length or rotation cross a step, so CV that moves within a
+/// step costs a comparison.
+class BeatxAdapter : public biexpand::BaseAdapter<BeatX> {
+   public:
+    using FloatIter = iters::FloatIter;
+    using BoolIter = iters::BoolIter;
+
+   private:
+    struct Rhythm {
+        BeatX::Mode mode = BeatX::Mode::EUCLIDEAN;
+        int hits = -1;
+        int length = 0;
+        int rotation = 0;
+        uint16_t mask = 0;
+        bool sameSteps(const Rhythm& other) const
+        {
+            return mode == other.mode && hits == other.hits && length == other.length &&
+                   rotation == other.rotation;
+        }
+    };
+    mutable std::array<Rhythm, constants::NUM_CHANNELS> rhythms;
+
+    int getStep(int paramId, int inputId, int channel, int min, int max) const
+    {
+        if (!ptr->inputs[inputId].isConnected()) {
+            return clamp(static_cast<int>(ptr->params[paramId].getValue()), min, max);
+        }
+        return clamp(static_cast<int>(rescale(ptr->inputs[inputId].getPolyVoltage(channel), 0, 10,
+                                              static_cast<float>(min),
+                                              static_cast<float>(max + 1))),
+                     min, max);
+    }
+    /// @brief The rhythm of channel, rebuilt when one of its controls crossed a step
+    /// @return true when the steps changed
+    bool updateRhythm(int channel) const
+    {
+        Rhythm next;
+        next.mode = static_cast<BeatX::Mode>(ptr->params[BeatX::PARAM_MODE].getValue());
+        next.length =
+            getStep(BeatX::PARAM_LENGTH, BeatX::INPUT_LENGTH, channel, 1, constants::MAX_STEPS);
+        next.hits = getStep(BeatX::PARAM_HITS, BeatX::INPUT_HITS, channel, 0, next.length);
+        next.rotation = getStep(BeatX::PARAM_ROTATION, BeatX::INPUT_ROTATION, channel, 0,
+                                constants::MAX_STEPS - 1);
+        Rhythm& rhythm = rhythms[channel];
+        if (rhythm.sameSteps(next)) { return false; }
+        if (next.mode == BeatX::Mode::NECKLACE) {
+            // Rotation picks one of 16 necklaces, spread over all of them
+            const std::vector<uint16_t>& necklaces =
+                beatx::Necklaces::get().of(next.hits, next.length);
+            const size_t index = necklaces.size() * next.rotation / constants::MAX_STEPS;
+            next.mask = necklaces[index];
+        }
+        else {
+            next.mask = beatx::rotate(beatx::euclid(next.hits, next.length),
+                                      next.rotation % next.length, next.length);
+        }
+        rhythm = next;
+        return true;
+    }
+    const Rhythm& getRhythm(int channel) const
+    {
+        updateRhythm(channel);
+        return rhythms[channel];
+    }
+
+    template <typename Iter>
+    Iter transformImpl(Iter out, int channel) const
+    {
+        const Rhythm& rhythm = getRhythm(channel);
+        for (int i = 0; i < rhythm.length; ++i, ++out) {
+            *out = (rhythm.mask & (1U << i)) != 0;
+        }
+        return out;
+    }
+
+   public:
+    /// @brief Input changes within a step don't need the host to transform again
+    bool needsRefresh() const override
+    {
+        if (!ptr->cacheState.needsRefreshing()) { return false; }
+        bool changed = false;
+        const int channels = std::max({ptr->inputs[BeatX::INPUT_HITS].getChannels(),
+                                       ptr->inputs[BeatX::INPUT_LENGTH].getChannels(),
+                                       ptr->inputs[BeatX::INPUT_ROTATION].getChannels(), 1});
+        for (int channel = 0; channel < channels; ++channel) {
+            changed |= updateRhythm(channel);
+        }
+        if (!changed) { ptr->cacheState.refresh(); }
+        return changed;
+    }
+    bool inPlace(int length, int channel) const override
+    {
+        return getRhythm(channel).length == length;
+    }
+    bool canQuery() const override
+    {
+        return true;
+    }
+    int queryLength(int /*inputLength*/, int channel) const override
+    {
+        return getRhythm(channel).length;
+    }
+    bool reordersIndices(int inputLength, int channel) const override
+    {
+        return getRhythm(channel).length != inputLength;
+    }
+    bool queryValue(int index, bool /*source*/, int channel) const override
+    {
+        return (getRhythm(channel).mask & (1U << index)) != 0;
+    }
+    uint16_t valueMask(int length, int /*channel*/) const override
+    {
+        return beatx::lengthMask(length);
+    }
+    /// @brief Input elements are overwritten, so only a new rhythm changes anything
+    uint16_t mapDirty(uint16_t /*dirty*/, int /*inputLength*/, int /*channel*/) const override
+    {
+        if (ptr->cacheState.getChangedParams() || ptr->cacheState.getChangedInputs()) {
+            return ALL_INDICES;
+        }
+        return 0;
+    }
+    void transformInPlace(BoolIter first, BoolIter /*last*/, int channel) const override
+    {
+        transformImpl(first, channel);
+    }
+    BoolIter transform(BoolIter /*first*/,
+                       BoolIter /*last*/,
+                       BoolIter out,
+                       int channel) const override
+    {
+        return transformImpl(out, channel);
+    }
+};
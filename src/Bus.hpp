@@ -0,0 +1,220 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <rack.hpp>
+#include <string>
+#include <vector>
+#include "constants.hpp"
+
+/// @brief Wireless buffers between modules
+/// @details An expandable sends its final buffer on a bus and others receive it as their source,
+/// without the sample delay and the per sample copies of a polyphonic cable. Buffers are only
+/// copied when they changed, every change bumps the generation of the bus.
+namespace bus {
+constexpr int NUM_BUSES = 8;
+
+/// @brief A buffer with a single sender and any number of receivers
+/// @details A seqlock: the generation is odd while the sender writes and even once the buffer
+/// is complete. A receiver keeps its copy unless the generation was even and unchanged across
+/// it, whatever the number of publishes in between, like a sender letting go of the bus and
+/// another one claiming it in the same sample. The elements are relaxed atomics, so a copy that
+/// is thrown away was still a defined read.
+class Bus {
+   public:
+    static constexpr int CAPACITY = constants::MAX_STEPS;
+    /// @brief Copies tried by a receiver before it keeps its previous buffer for this sample
+    static constexpr int READ_ATTEMPTS = 4;
+
+    /// @brief A receiver's copy of the buffer
+    struct Snapshot {
+        std::array<float, CAPACITY> values{};
+        int length = 0;
+        /// @brief The generation that was read, always even
+        uint32_t generation = 0;
+    };
+
+    /// @brief Sender only
+    template <typename Iter>
+    void publish(Iter first, Iter last)
+    {
+        const uint32_t writing = generation.load(std::memory_order_relaxed) + 1;
+        generation.store(writing, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        const int size = std::min(static_cast<int>(last - first), CAPACITY);
+        length.store(size, std::memory_order_relaxed);
+        for (int i = 0; i < size; ++i) {
+            values[i].store(first[i], std::memory_order_relaxed);
+        }
+        generation.store(writing + 1, std::memory_order_release);
+    }
+    /// @brief 0 until the first publish, odd while a publish is under way
+    uint32_t getGeneration() const
+    {
+        return generation.load(std::memory_order_acquire);
+    }
+    /// @brief Copies the current buffer into snapshot
+    /// @details Gives up after READ_ATTEMPTS copies that overlapped a publish, so a sender that
+    /// stalls mid-publish can't hang the engine thread.
+    /// @return false when snapshot was left as it was
+    bool read(Snapshot& snapshot) const
+    {
+        Snapshot copy;
+        for (int attempt = 0; attempt < READ_ATTEMPTS; ++attempt) {
+            copy.generation = generation.load(std::memory_order_acquire);
+            if (copy.generation & 1U) { continue; }
+            // A torn length is thrown away below, but must not overrun values first
+            copy.length = std::clamp(length.load(std::memory_order_relaxed), 0, CAPACITY);
+            for (int i = 0; i < copy.length; ++i) {
+                copy.values[i] = values[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (generation.load(std::memory_order_relaxed) == copy.generation) {
+                snapshot = copy;
+                return true;
+            }
+        }
+        return false;
+    }
+    /// @brief Makes sender the only one that publishes on this bus
+    bool claim(const void* sender)
+    {
+        const void* expected = nullptr;
+        return owner.compare_exchange_strong(expected, sender) || expected == sender;
+    }
+    void release(const void* sender)
+    {
+        const void* expected = sender;
+        owner.compare_exchange_strong(expected, nullptr);
+    }
+
+   private:
+    std::array<std::atomic<float>, CAPACITY> values{};
+    std::atomic<int> length{0};
+    std::atomic<uint32_t> generation{0};
+    std::atomic<const void*> owner{nullptr};
+};
+
+inline Bus& get(int index)
+{
+    static std::array<Bus, NUM_BUSES> buses;
+    return buses[index];
+}
+
+/// @brief The sending side of a module
+/// @details select() may be called from any thread, the engine thread picks the change up in
+/// publish(). A bus that already has a sender is claimed as soon as that sender lets go. A buffer
+/// equal to the one last sent isn't published again, so a loop of unchanging modules settles.
+class Sender {
+   public:
+    ~Sender()
+    {
+        if (current < 0) { return; }
+        const float* none = nullptr;
+        get(current).publish(none, none);
+        get(current).release(this);
+    }
+    /// @param index The bus, -1 for none
+    void select(int index)
+    {
+        selected.store(rack::clamp(index, -1, NUM_BUSES - 1), std::memory_order_relaxed);
+    }
+    int getSelected() const
+    {
+        return selected.load(std::memory_order_relaxed);
+    }
+    /// @brief Call on the engine thread every sample
+    /// @param changed Whether the buffer changed since the last call
+    template <typename Iter>
+    void publish(Iter first, Iter last, bool changed)
+    {
+        const int index = getSelected();
+        if (index != current) {
+            if (current >= 0) {
+                // Receivers of the old bus go quiet rather than keep a stale buffer
+                get(current).publish(first, first);
+                get(current).release(this);
+            }
+            current = -1;
+            if (index >= 0 && get(index).claim(this)) { current = index; }
+            sentLength = -1;
+        }
+        if (current < 0 || !(changed || sentLength < 0)) { return; }
+        const int length = std::min(static_cast<int>(last - first), Bus::CAPACITY);
+        if (length == sentLength && std::equal(first, first + length, sent.begin())) { return; }
+        sentLength = length;
+        std::copy(first, first + length, sent.begin());
+        get(current).publish(first, last);
+    }
+
+   private:
+    std::atomic<int> selected{-1};
+    /// @brief The bus claimed by the engine thread
+    int current = -1;
+    /// @brief The buffer last published on current, -1 for none yet
+    std::array<float, Bus::CAPACITY> sent{};
+    int sentLength = -1;
+};
+
+/// @brief The receiving side of a module
+class Receiver {
+   public:
+    /// @param index The bus, -1 for none
+    void select(int index)
+    {
+        selected.store(rack::clamp(index, -1, NUM_BUSES - 1), std::memory_order_relaxed);
+    }
+    int getSelected() const
+    {
+        return selected.load(std::memory_order_relaxed);
+    }
+    /// @brief Whether the engine thread reads from a bus
+    explicit operator bool() const
+    {
+        return current >= 0;
+    }
+    /// @brief Whether there is a buffer that wasn't read yet, or another bus was selected
+    bool hasNews()
+    {
+        const int index = getSelected();
+        if (index != current) {
+            current = index;
+            // Nothing of the old bus to fall back to
+            snapshot = {};
+            return true;
+        }
+        return current >= 0 && get(current).getGeneration() != snapshot.generation;
+    }
+    /// @brief Copies the buffer of the bus, the previous one while the sender keeps writing
+    /// @details A failed read leaves the news pending, the next sample tries again.
+    template <typename Container>
+    void read(Container& buffer)
+    {
+        if (current < 0) {
+            buffer.clear();
+            return;
+        }
+        get(current).read(snapshot);
+        buffer.assign(snapshot.values.begin(), snapshot.values.begin() + snapshot.length);
+    }
+
+   private:
+    std::atomic<int> selected{-1};
+    int current = -1;
+    /// @brief The buffer last read from current
+    Bus::Snapshot snapshot;
+};
+
+/// @brief Submenu to pick a bus, -1 being Off
+inline rack::ui::MenuItem* createMenuItem(const std::string& text,
+                                          const std::function<int()>& getBus,
+                                          const std::function<void(int)>& setBus)
+{
+    const std::vector<std::string> labels = {"Off", "A", "B", "C", "D", "E", "F", "G", "H"};
+    return rack::createIndexSubmenuItem(
+        text, labels, [getBus]() { return static_cast<size_t>(getBus() + 1); },
+        [setBus](size_t index) { setBus(static_cast<int>(index) - 1); });
+}
+}  // namespace bus
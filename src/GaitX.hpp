@@ -108,4 +108,12 @@ class GaitXAdapter : public biexpand::BaseAdapter<GaitX> {
     {
         return true;
     }
+    bool canQuery() const override
+    {
+        return true;
+    }
+    bool reordersIndices(int /*inputLength*/, int /*channel*/) const override
+    {
+        return false;
+    }
 };
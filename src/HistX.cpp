@@ -0,0 +1,62 @@
+#include "HistX.hpp"
+#include "comp/knobs.hpp"
+#include "comp/ports.hpp"
+#include "comp/switches.hpp"
+#include "constants.hpp"
+#include "plugin.hpp"
+
+HistX::HistX() : biexpand::BiExpander(false)
+{
+    config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+
+    configParam<biexpand::CachedParamQuantity<>>(PARAM_TAP, 0.0F, 16.0F, 1.0F, "Tap",
+                                                 " steps ago");
+    getParamQuantity(PARAM_TAP)->snapEnabled = true;
+    configSwitch(PARAM_LOOP, 0.0F, 1.0F, 0.0F, "Loop", {"Off", "On"});
+    configInput(INPUT_TAP, "Tap CV");
+    configInput(INPUT_LOOP, "Loop gate");
+    configInput(INPUT_STEP, "Step");
+    // The history moves on steps, not on changes of these
+    configCache({INPUT_LOOP, INPUT_STEP}, {PARAM_LOOP});
+};
+
+void HistX::process(const ProcessArgs& /*args*/)
+{
+    if (stepTrigger.process(inputs[INPUT_STEP].getVoltage(), 0.1F, 1.F)) {
+        steps.fetch_add(1, std::memory_order_release);
+    }
+    lights[LIGHT_LOOP].setBrightness(isLooping() ? 1.F : 0.F);
+}
+
+using namespace dimensions;  // NOLINT
+struct HistXWidget : public SIMWidget {
+    explicit HistXWidget(HistX* module)
+    {
+        const float center = 1.F * HP;
+        setModule(module);
+        setSIMPanel("HistX");
+
+        if (module) {
+            module->connectionLights.addDefaultConnectionLights(this, -1,
+                                                                HistX::LIGHT_RIGHT_CONNECTED);
+        }
+
+        addParam(createParamCentered<comp::SIMKnob>(
+            mm2px(Vec(center, JACKYSTART + 0 * PARAMJACKNTXT)), module, HistX::PARAM_TAP));
+        addInput(createInputCentered<comp::SIMPort>(
+            mm2px(Vec(center, JACKYSTART + 0 * PARAMJACKNTXT + JACKYSPACE)), module,
+            HistX::INPUT_TAP));
+
+        addParam(createLightParamCentered<comp::SIMLightLatch<MediumSimpleLight<WhiteLight>>>(
+            mm2px(Vec(center, JACKYSTART + 1 * PARAMJACKNTXT)), module, HistX::PARAM_LOOP,
+            HistX::LIGHT_LOOP));
+        addInput(createInputCentered<comp::SIMPort>(
+            mm2px(Vec(center, JACKYSTART + 1 * PARAMJACKNTXT + JACKYSPACE)), module,
+            HistX::INPUT_LOOP));
+
+        addInput(createInputCentered<comp::SIMPort>(
+            mm2px(Vec(center, JACKYSTART + 2 * PARAMJACKNTXT + JACKYSPACE)), module,
+            HistX::INPUT_STEP));
+    }
+};
+Model* modelHistX = createModel<HistX, HistXWidget>("HistX");  // NOLINT
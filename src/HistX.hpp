@@ -0,0 +1,197 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <rack.hpp>
+#include "biexpander/biexpander.hpp"
+#include "constants.hpp"
+#include "helpers/iters.hpp"
+
+using namespace rack;  // NOLINT
+
+struct HistX : public biexpand::BiExpander {
+    enum ParamId { PARAM_TAP, PARAM_LOOP, PARAMS_LEN };
+    enum InputId { INPUT_TAP, INPUT_LOOP, INPUT_STEP, INPUTS_LEN };
+    enum OutputId { OUTPUTS_LEN };
+    enum LightId { LIGHT_RIGHT_CONNECTED, LIGHT_LOOP, LIGHTS_LEN };
+    HistX();
+    void process(const ProcessArgs& args) override;
+
+    /// @brief Number of rising edges at the step input so far, read by the adapter
+    uint32_t getSteps() const
+    {
+        return steps.load(std::memory_order_acquire);
+    }
+    /// @brief Whether the snapshots are looped instead of replaced by new ones
+    bool isLooping()
+    {
+        return params[PARAM_LOOP].getValue() > 0.F || inputs[INPUT_LOOP].getVoltage() > 1.F;
+    }
+
+   private:
+    dsp::SchmittTrigger stepTrigger;
+    std::atomic<uint32_t> steps{0};
+};
+
+namespace histx {
+/// @brief Snapshots of a buffer in one preallocated block, newest first
+/// @details The snapshots are rows of a fixed arena used as a ring. Advancing moves the head
+/// row, nothing is copied, so a step costs one row write however long the history is.
+template <int STAGES, int WIDTH>
+class RingArena {
+    static_assert((STAGES & (STAGES - 1)) == 0, "STAGES must be a power of two");
+
+   public:
+    /// @brief The snapshot taken age steps ago, 0 being the newest
+    const float* row(int age) const
+    {
+        return arena.data() + index(age) * WIDTH;
+    }
+    int length(int age) const
+    {
+        return lengths[index(age)];
+    }
+    /// @brief Makes room for a new snapshot, dropping the oldest
+    void advance()
+    {
+        head = (head + 1) & (STAGES - 1);
+    }
+    /// @brief Overwrites the newest snapshot
+    template <typename Iter>
+    void write(Iter first, int length)
+    {
+        std::copy(first, first + length, arena.begin() + head * WIDTH);
+        lengths[head] = static_cast<uint8_t>(length);
+    }
+    /// @brief Overwrites the newest snapshot with the one taken age steps ago
+    /// @details After advance() the newest row still holds the snapshot of STAGES steps ago, so
+    /// for that age it is kept.
+    void writeFrom(int age)
+    {
+        if (index(age) == head) { return; }
+        std::copy_n(row(age), WIDTH, arena.begin() + head * WIDTH);
+        lengths[head] = lengths[index(age)];
+    }
+
+   private:
+    std::array<float, STAGES * WIDTH> arena{};
+    std::array<uint8_t, STAGES> lengths{};
+    int head = 0;
+    int index(int age) const
+    {
+        return (head - age) & (STAGES - 1);
+    }
+};
+}  // namespace histx
+
+/// @brief Replaces the buffer by the one seen a number of steps ago
+/// @details On every rising edge at the step input the buffer as it enters the adapter is
+/// stored, or, while looping, the snapshot of tap steps ago is stored again so that the last
+/// tap snapshots repeat. The history is shared by the channels of a poly chain and recorded from
+/// the first one. A history that doesn't reach back far enough passes the buffer unchanged.
+class HistxAdapter : public biexpand::BaseAdapter<HistX> {
+   public:
+    using FloatIter = iters::FloatIter;
+    using BoolIter = iters::BoolIter;
+
+   private:
+    static constexpr int STAGES = constants::MAX_STEPS;
+    mutable histx::RingArena<STAGES, constants::MAX_STEPS> history;
+    /// @brief The buffer as it last entered the adapter, stored on the next step
+    mutable std::array<float, constants::MAX_STEPS> latest{};
+    mutable int latestLength = 0;
+    mutable uint32_t seenSteps = 0;
+
+    /// @brief How many steps ago the snapshot read is taken, 0 for none, up to STAGES
+    /// @details Tap t reads the snapshot of age t - 1, so all STAGES snapshots can be read. The CV
+    /// spreads the STAGES + 1 taps evenly over 0V to 10V.
+    int getTap(int channel) const
+    {
+        if (!ptr->inputs[HistX::INPUT_TAP].isConnected()) {
+            return clamp(static_cast<int>(ptr->params[HistX::PARAM_TAP].getValue()), 0, STAGES);
+        }
+        return clamp(static_cast<int>(rescale(ptr->inputs[HistX::INPUT_TAP].getPolyVoltage(channel),
+                                              0, 10, 0.F, static_cast<float>(STAGES + 1))),
+                     0, STAGES);
+    }
+    /// @brief Stores a snapshot for every step since the last call
+    /// @return true when the history moved
+    bool followSteps() const
+    {
+        const uint32_t steps = ptr->getSteps();
+        if (steps == seenSteps) { return false; }
+        const int count = static_cast<int>(std::min<uint32_t>(steps - seenSteps, STAGES));
+        seenSteps = steps;
+        const bool looping = ptr->isLooping();
+        const int loopLength = std::max(getTap(0), 1);
+        for (int i = 0; i < count; ++i) {
+            history.advance();
+            if (looping) { history.writeFrom(loopLength); }
+            else {
+                history.write(latest.begin(), latestLength);
+            }
+        }
+        return true;
+    }
+    /// @brief The snapshot channel reads, nullptr for the buffer itself
+    const float* getSnapshot(int channel, int& length) const
+    {
+        const int tap = getTap(channel);
+        if (tap == 0) { return nullptr; }
+        length = history.length(tap - 1);
+        return length == 0 ? nullptr : history.row(tap - 1);
+    }
+    template <typename Iter>
+    void remember(Iter first, Iter last, int channel) const
+    {
+        if (channel != 0) { return; }
+        // Steps not seen yet store the previous buffer
+        followSteps();
+        latestLength = static_cast<int>(last - first);
+        std::copy(first, last, latest.begin());
+    }
+    template <typename Iter>
+    Iter transformImpl(Iter first, Iter last, Iter out, int channel) const
+    {
+        remember(first, last, channel);
+        int length = 0;
+        const float* snapshot = getSnapshot(channel, length);
+        if (!snapshot) { return std::copy(first, last, out); }
+        for (int i = 0; i < length; ++i, ++out) {
+            *out = static_cast<typename std::iterator_traits<Iter>::value_type>(snapshot[i]);
+        }
+        return out;
+    }
+
+   public:
+    /// @brief A step moves the history, which needs a transform even without other changes
+    bool needsRefresh() const override
+    {
+        const bool changed = ptr->cacheState.needsRefreshing();
+        return followSteps() || changed;
+    }
+    bool inPlace(int length, int channel) const override
+    {
+        followSteps();
+        int snapshotLength = 0;
+        return !getSnapshot(channel, snapshotLength) || snapshotLength == length;
+    }
+    void transformInPlace(FloatIter first, FloatIter last, int channel) const override
+    {
+        transformImpl(first, last, first, channel);
+    }
+    void transformInPlace(BoolIter first, BoolIter last, int channel) const override
+    {
+        transformImpl(first, last, first, channel);
+    }
+    FloatIter transform(FloatIter first, FloatIter last, FloatIter out, int channel) const override
+    {
+        return transformImpl(first, last, out, channel);
+    }
+    BoolIter transform(BoolIter first, BoolIter last, BoolIter out, int channel) const override
+    {
+        return transformImpl(first, last, out, channel);
+    }
+};
@@ -7,8 +7,9 @@
 InX::InX() : biexpand::BiExpander(false)
 {
     config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
-    configSwitch(PARAM_INSERTMODE, 0.0, 2.0, 0.0, "mode",
-                 {"Overwrite", "Insert", "Add for voltages (AND for gates)"});
+    configSwitch<biexpand::CachedParamQuantity<SwitchQuantity>>(
+        PARAM_INSERTMODE, 0.0, 2.0, 0.0, "mode",
+        {"Overwrite", "Insert", "Add for voltages (AND for gates)"});
     configCache();
 };
 
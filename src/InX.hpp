@@ -113,6 +113,48 @@ class InxAdapter : public biexpand::BaseAdapter<InX> {
     {
         return !(getInsertMode() == InX::InsertMode::INSERT);
     }
+    /// @brief Overwrite and add/and keep every element in place, insert shifts them
+    bool canQuery() const override
+    {
+        return ptr && getInsertMode() != InX::InsertMode::INSERT;
+    }
+    bool reordersIndices(int /*inputLength*/, int /*channel*/) const override
+    {
+        return false;
+    }
+    /// @brief The elements at the indices of connected ports
+    uint16_t valueMask(int /*length*/, int /*channel*/) const override
+    {
+        uint16_t mask = 0;
+        for (int i = 0; i < constants::NUM_CHANNELS; i++) {
+            if (ptr->inputs[i].isConnected()) { mask |= 1U << i; }
+        }
+        return mask;
+    }
+    /// @brief A changed port changes the element at its index, a mode change changes all
+    uint16_t mapDirty(uint16_t dirty, int /*inputLength*/, int /*channel*/) const override
+    {
+        if (ptr->cacheState.getChangedParams()) { return ALL_INDICES; }
+        return dirty | ptr->cacheState.getChangedInputs();
+    }
+    float queryValue(int index, float source, int channel) const override
+    {
+        if (index >= constants::NUM_CHANNELS || !ptr->inputs[index].isConnected()) {
+            return source;
+        }
+        const float value = ptr->inputs[index].getVoltage(channel) +
+                            (getInsertMode() == InX::InsertMode::ADD_AND ? source : 0.F);
+        const std::function<float(float)> f = this->getFloatValueFunction();
+        return f ? f(value) : value;
+    }
+    bool queryValue(int index, bool source, int channel) const override
+    {
+        if (index >= constants::NUM_CHANNELS || !ptr->inputs[index].isConnected()) {
+            return source;
+        }
+        const bool value = ptr->inputs[index].getVoltage(channel) > BOOLTRIGGER;
+        return getInsertMode() == InX::InsertMode::ADD_AND ? value && source : value;
+    }
 
     template <typename Iter>
     void transformImplInPlace(Iter first, Iter last, Iter out, int channel = 0) const
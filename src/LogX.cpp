@@ -0,0 +1,74 @@
+#include "LogX.hpp"
+#include "comp/knobs.hpp"
+#include "comp/ports.hpp"
+#include "constants.hpp"
+#include "helpers/ModuleIterator.hpp"
+#include "plugin.hpp"
+
+LogX::LogX() : biexpand::BiExpander(false)
+{
+    config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+
+    configSwitch<biexpand::CachedParamQuantity<SwitchQuantity>>(PARAM_OP, 0.0F, 3.0F, 0.0F,
+                                                                "Operation",
+                                                                {"AND", "OR", "XOR", "NAND"});
+    configInput(INPUT_OP, "Operation CV");
+    configCache();
+};
+
+uint32_t LogX::getSourceGates()
+{
+    const uint32_t generation = getLayoutGeneration();
+    if (generation != sourceGeneration) {
+        sourceGeneration = generation;
+        source = findSource();
+    }
+    return source ? logx::bankGates(*source) : 0;
+}
+
+const Module* LogX::findSource() const
+{
+    // The SIM modules with chain events, any other module (a Coerce too) ends the walk
+    static const AnyOf crossed({modelPhi, modelArr, modelVia, modelSpike, modelReX, modelInX,
+                                modelOutX, modelModX, modelGaitX, modelBeatX, modelLogX,
+                                modelSortX, modelMathX, modelHistX});
+    const ModuleReverseIterator end(nullptr);
+    ModuleReverseIterator found =
+        std::find_if_not(ModuleReverseIterator(leftExpander.module), end, crossed);
+    return found != end && found->model == modelBank ? &*found : nullptr;
+}
+
+using namespace dimensions;  // NOLINT
+struct LogXWidget : public SIMWidget {
+    explicit LogXWidget(LogX* module)
+    {
+        const float center = 1.F * HP;
+        setModule(module);
+        setSIMPanel("LogX");
+
+        if (module) {
+            module->connectionLights.addDefaultConnectionLights(this, -1,
+                                                                LogX::LIGHT_RIGHT_CONNECTED);
+        }
+
+        addParam(createParamCentered<comp::SIMKnob>(mm2px(Vec(center, JACKYSTART)), module,
+                                                    LogX::PARAM_OP));
+        addInput(createInputCentered<comp::SIMPort>(mm2px(Vec(center, JACKYSTART + JACKYSPACE)),
+                                                    module, LogX::INPUT_OP));
+    }
+
+    void appendContextMenu(Menu* menu) override
+    {
+        auto* module = dynamic_cast<LogX*>(this->module);
+        assert(module);  // NOLINT
+
+        menu->addChild(createIndexSubmenuItem(
+            "Operation", {"AND", "OR", "XOR", "NAND"},
+            [module]() { return static_cast<size_t>(module->params[LogX::PARAM_OP].getValue()); },
+            [module](size_t op) {
+                module->params[LogX::PARAM_OP].setValue(static_cast<float>(op));
+            }));
+        SIMWidget::appendContextMenu(menu);
+    }
+};
+Model* modelLogX = createModel<LogX, LogXWidget>("LogX");  // NOLINT
@@ -0,0 +1,167 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <rack.hpp>
+#include "biexpander/biexpander.hpp"
+#include "constants.hpp"
+#include "helpers/iters.hpp"
+
+using namespace rack;  // NOLINT
+
+struct LogX : public biexpand::BiExpander {
+    enum ParamId { PARAM_OP, PARAMS_LEN };
+    enum InputId { INPUT_OP, INPUTS_LEN };
+    enum OutputId { OUTPUTS_LEN };
+    enum LightId { LIGHT_RIGHT_CONNECTED, LIGHTS_LEN };
+    enum class Op { AND, OR, XOR, NAND };
+    LogX();
+
+    /// @brief The gates of the first Bank to the left, see logx::Gates
+    /// @details The Bank is looked up again only after the layout changed, see
+    /// Connectable::getLayoutGeneration(), otherwise this is a load of its gates word.
+    uint32_t getSourceGates();
+
+   private:
+    const Module* source = nullptr;
+    /// @brief The layout generation source was looked up in, starts out of date
+    uint32_t sourceGeneration = getLayoutGeneration() - 1;
+
+    /// @brief Walks left across SIM modules, every link on the way is watched by a chain event
+    const Module* findSource() const;
+};
+
+namespace logx {
+/// @brief A gate buffer of up to 16 steps packed in a word: the length in the upper 16 bits,
+/// step i in bit i of the lower 16 bits. 0 means there is no source.
+using Gates = uint32_t;
+inline constexpr Gates pack(int length, uint16_t mask)
+{
+    return (static_cast<uint32_t>(length) << 16U) | mask;
+}
+inline constexpr int length(Gates gates)
+{
+    return static_cast<int>(gates >> 16U);
+}
+/// @brief The gates repeated over 16 steps, so that a short source wraps like Re<sup>x</sup>
+inline constexpr uint16_t tile(Gates gates)
+{
+    const int len = length(gates);
+    if (len == 0) { return 0; }
+    uint32_t mask = gates & 0xFFFFU;
+    for (int filled = len; filled < constants::MAX_STEPS; filled *= 2) {
+        mask |= mask << filled;
+    }
+    return static_cast<uint16_t>(mask);
+}
+inline constexpr uint16_t apply(LogX::Op op, uint16_t host, uint16_t source)
+{
+    switch (op) {
+        case LogX::Op::AND: return host & source;
+        case LogX::Op::OR: return host | source;
+        case LogX::Op::XOR: return host ^ source;
+        case LogX::Op::NAND: return ~(host & source);
+    }
+    return host;
+}
+/// @brief The gates published by a Bank, defined in Bank.cpp
+Gates bankGates(const Module& bank);
+}  // namespace logx
+
+/// @brief Combines the gate buffer with the gates of a second Bank, one word op per channel
+/// @details The source is read once per sample in needsRefresh() and only a changed word makes
+/// the host transform again.
+class LogxAdapter : public biexpand::BaseAdapter<LogX> {
+   public:
+    using FloatIter = iters::FloatIter;
+    using BoolIter = iters::BoolIter;
+
+   private:
+    /// @brief Source gates as of the last check, tiled to 16 steps
+    mutable logx::Gates seenGates = 0;
+    mutable uint16_t sourceMask = 0;
+
+    void updateSource() const
+    {
+        const logx::Gates gates = ptr->getSourceGates();
+        if (gates == seenGates) { return; }
+        seenGates = gates;
+        sourceMask = logx::tile(gates);
+    }
+    LogX::Op getOp(int channel) const
+    {
+        constexpr int lastOp = static_cast<int>(LogX::Op::NAND);
+        if (!ptr->inputs[LogX::INPUT_OP].isConnected()) {
+            return static_cast<LogX::Op>(
+                clamp(static_cast<int>(ptr->params[LogX::PARAM_OP].getValue()), 0, lastOp));
+        }
+        return static_cast<LogX::Op>(
+            clamp(static_cast<int>(rescale(ptr->inputs[LogX::INPUT_OP].getPolyVoltage(channel), 0,
+                                           10, 0.F, static_cast<float>(lastOp + 1))),
+                  0, lastOp));
+    }
+    bool hasSource() const
+    {
+        return seenGates != 0;
+    }
+
+   public:
+    bool needsRefresh() const override
+    {
+        const bool changed = ptr->cacheState.needsRefreshing();
+        const logx::Gates previous = seenGates;
+        updateSource();
+        if (seenGates == previous) { return changed; }
+        ptr->cacheState.setInputDirty();
+        return true;
+    }
+    bool inPlace(int /*length*/, int /*channel*/) const override
+    {
+        return true;
+    }
+    bool canQuery() const override
+    {
+        return true;
+    }
+    bool reordersIndices(int /*inputLength*/, int /*channel*/) const override
+    {
+        return false;
+    }
+    bool queryValue(int index, bool source, int channel) const override
+    {
+        if (!hasSource()) { return source; }
+        const uint16_t host = source ? 1U << index : 0U;
+        return (logx::apply(getOp(channel), host, sourceMask) & (1U << index)) != 0;
+    }
+    uint16_t valueMask(int length, int /*channel*/) const override
+    {
+        return hasSource() ? static_cast<uint16_t>((1U << length) - 1U) : 0;
+    }
+    /// @brief Step i only depends on step i, unless the source or the operation changed
+    uint16_t mapDirty(uint16_t dirty, int /*inputLength*/, int /*channel*/) const override
+    {
+        if (ptr->cacheState.getChangedParams() || ptr->cacheState.getChangedInputs()) {
+            return ALL_INDICES;
+        }
+        return dirty;
+    }
+    void transformInPlace(BoolIter first, BoolIter last, int channel) const override
+    {
+        updateSource();
+        if (!hasSource()) { return; }
+        const int length = static_cast<int>(last - first);
+        uint16_t host = 0;
+        for (int i = 0; i < length; ++i) {
+            if (first[i]) { host |= 1U << i; }
+        }
+        const uint16_t result = logx::apply(getOp(channel), host, sourceMask);
+        for (int i = 0; i < length; ++i) {
+            first[i] = (result & (1U << i)) != 0;
+        }
+    }
+    BoolIter transform(BoolIter first, BoolIter last, BoolIter out, int channel) const override
+    {
+        BoolIter end = std::copy(first, last, out);
+        transformInPlace(out, end, channel);
+        return end;
+    }
+};
@@ -0,0 +1,80 @@
+#include "MathX.hpp"
+#include "comp/knobs.hpp"
+#include "comp/ports.hpp"
+#include "constants.hpp"
+#include "plugin.hpp"
+
+namespace {
+const std::vector<std::string> limitLabels = {"Off", "Clamp", "Fold", "Wrap"};
+const std::vector<std::string> rangeLabels = {"0V-10V",  "0V-5V", "0V-3V", "0V-1V",
+                                              "+/-10V", "+/-5V", "+/-3V", "+/-1V"};
+}  // namespace
+
+MathX::MathX() : biexpand::BiExpander(false)
+{
+    config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+
+    configParam<biexpand::CachedParamQuantity<>>(PARAM_SCALE, -2.0F, 2.0F, 1.0F, "Scale", "x");
+    configParam<biexpand::CachedParamQuantity<>>(PARAM_OFFSET, -10.0F, 10.0F, 0.0F, "Offset",
+                                                 "V");
+    configSwitch<biexpand::CachedParamQuantity<SwitchQuantity>>(PARAM_LIMIT, 0.0F, 3.0F, 0.0F,
+                                                                "Limit", limitLabels);
+    configSwitch<biexpand::CachedParamQuantity<SwitchQuantity>>(
+        PARAM_RANGE, 0.0F, 7.0F, static_cast<float>(constants::MINUS_TEN_TO_TEN), "Limit range",
+        rangeLabels);
+    configInput(INPUT_SCALE, "Scale CV (per step, 10V is unity)");
+    configInput(INPUT_OFFSET, "Offset CV (per step)");
+    configCache();
+};
+
+using namespace dimensions;  // NOLINT
+struct MathXWidget : public SIMWidget {
+    explicit MathXWidget(MathX* module)
+    {
+        const float center = 1.F * HP;
+        setModule(module);
+        setSIMPanel("MathX");
+
+        if (module) {
+            module->connectionLights.addDefaultConnectionLights(this, -1,
+                                                                MathX::LIGHT_RIGHT_CONNECTED);
+        }
+
+        addParam(createParamCentered<comp::SIMKnob>(
+            mm2px(Vec(center, JACKYSTART + 0 * PARAMJACKNTXT)), module, MathX::PARAM_SCALE));
+        addInput(createInputCentered<comp::SIMPort>(
+            mm2px(Vec(center, JACKYSTART + 0 * PARAMJACKNTXT + JACKYSPACE)), module,
+            MathX::INPUT_SCALE));
+
+        addParam(createParamCentered<comp::SIMKnob>(
+            mm2px(Vec(center, JACKYSTART + 1 * PARAMJACKNTXT)), module, MathX::PARAM_OFFSET));
+        addInput(createInputCentered<comp::SIMPort>(
+            mm2px(Vec(center, JACKYSTART + 1 * PARAMJACKNTXT + JACKYSPACE)), module,
+            MathX::INPUT_OFFSET));
+    }
+
+    void appendContextMenu(Menu* menu) override
+    {
+        auto* module = dynamic_cast<MathX*>(this->module);
+        assert(module);  // NOLINT
+
+        menu->addChild(createIndexSubmenuItem(
+            "Limit", limitLabels,
+            [module]() {
+                return static_cast<size_t>(module->params[MathX::PARAM_LIMIT].getValue());
+            },
+            [module](size_t limit) {
+                module->params[MathX::PARAM_LIMIT].setValue(static_cast<float>(limit));
+            }));
+        menu->addChild(createIndexSubmenuItem(
+            "Limit range", rangeLabels,
+            [module]() {
+                return static_cast<size_t>(module->params[MathX::PARAM_RANGE].getValue());
+            },
+            [module](size_t range) {
+                module->params[MathX::PARAM_RANGE].setValue(static_cast<float>(range));
+            }));
+        SIMWidget::appendContextMenu(menu);
+    }
+};
+Model* modelMathX = createModel<MathX, MathXWidget>("MathX");  // NOLINT
@@ -0,0 +1,143 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <rack.hpp>
+#include "biexpander/biexpander.hpp"
+#include "constants.hpp"
+#include "helpers/iters.hpp"
+
+using namespace rack;  // NOLINT
+
+struct MathX : public biexpand::BiExpander {
+    enum ParamId { PARAM_SCALE, PARAM_OFFSET, PARAM_LIMIT, PARAM_RANGE, PARAMS_LEN };
+    enum InputId { INPUT_SCALE, INPUT_OFFSET, INPUTS_LEN };
+    enum OutputId { OUTPUTS_LEN };
+    enum LightId { LIGHT_RIGHT_CONNECTED, LIGHTS_LEN };
+    enum class Limit { OFF, CLAMP, FOLD, WRAP };
+    MathX();
+};
+
+/// @brief Scales and offsets every voltage, then limits it to a range by clamping, folding or
+/// wrapping
+/// @details The CV inputs work per slot: channel i of a polyphonic cable modulates element i of
+/// the buffer, a monophonic cable all of them. Four slots are computed at a time.
+class MathxAdapter : public biexpand::BaseAdapter<MathX> {
+   public:
+    using FloatIter = iters::FloatIter;
+    using BoolIter = iters::BoolIter;
+
+   private:
+    using float_4 = simd::float_4;
+
+    /// @brief The scale of four slots, the CV is 10V for unity so the knob is an attenuverter
+    float_4 getScale(int slot) const
+    {
+        const float scale = ptr->params[MathX::PARAM_SCALE].getValue();
+        Input& input = ptr->inputs[MathX::INPUT_SCALE];
+        if (!input.isConnected()) { return scale; }
+        return scale * loadSlots(input, slot) * 0.1F;
+    }
+    float_4 getOffset(int slot) const
+    {
+        const float offset = ptr->params[MathX::PARAM_OFFSET].getValue();
+        Input& input = ptr->inputs[MathX::INPUT_OFFSET];
+        if (!input.isConnected()) { return offset; }
+        return offset + loadSlots(input, slot);
+    }
+    static float_4 loadSlots(Input& input, int slot)
+    {
+        if (input.getChannels() == 1) { return input.getVoltage(); }
+        return float_4::load(input.getVoltages(slot));
+    }
+    MathX::Limit getLimit() const
+    {
+        return static_cast<MathX::Limit>(ptr->params[MathX::PARAM_LIMIT].getValue());
+    }
+    std::pair<float, float> getRange() const
+    {
+        const int range = clamp(static_cast<int>(ptr->params[MathX::PARAM_RANGE].getValue()), 0,
+                                static_cast<int>(constants::voltageRangeMinMax.size()) - 1);
+        return constants::voltageRangeMinMax[range].second;
+    }
+    /// @brief Slots slot to slot + 3 of values
+    float_4 compute(float_4 values, int slot) const
+    {
+        values = values * getScale(slot) + getOffset(slot);
+        const MathX::Limit limit = getLimit();
+        if (limit == MathX::Limit::OFF) { return values; }
+        const auto [low, high] = getRange();
+        switch (limit) {
+            case MathX::Limit::CLAMP: return simd::clamp(values, low, high);
+            case MathX::Limit::FOLD: {
+                // A triangle over twice the range
+                const float_4 phase = (values - low) / (2.F * (high - low));
+                const float_4 triangle = 1.F - simd::fabs(2.F * (phase - simd::floor(phase)) - 1.F);
+                return low + triangle * (high - low);
+            }
+            case MathX::Limit::WRAP: {
+                const float_4 phase = (values - low) / (high - low);
+                return low + (phase - simd::floor(phase)) * (high - low);
+            }
+            default: return values;
+        }
+    }
+
+   public:
+    bool inPlace(int /*length*/, int /*channel*/) const override
+    {
+        return true;
+    }
+    bool canQuery() const override
+    {
+        return true;
+    }
+    bool reordersIndices(int /*inputLength*/, int /*channel*/) const override
+    {
+        return false;
+    }
+    uint16_t valueMask(int length, int /*channel*/) const override
+    {
+        return static_cast<uint16_t>((1U << length) - 1U);
+    }
+    /// @brief Element i only depends on element i, unless a control changed
+    uint16_t mapDirty(uint16_t dirty, int /*inputLength*/, int /*channel*/) const override
+    {
+        if (ptr->cacheState.getChangedParams() || ptr->cacheState.getChangedInputs()) {
+            return ALL_INDICES;
+        }
+        return dirty;
+    }
+    float queryValue(int index, float source, int /*channel*/) const override
+    {
+        const int slot = index - index % 4;
+        std::array<float, 4> values{};
+        values[index - slot] = source;
+        compute(float_4::load(values.data()), slot).store(values.data());
+        const std::function<float(float)> f = this->getFloatValueFunction();
+        return f ? f(values[index - slot]) : values[index - slot];
+    }
+    void transformInPlace(FloatIter first, FloatIter last, int /*channel*/) const override
+    {
+        const int length = static_cast<int>(last - first);
+        std::array<float, constants::MAX_STEPS> values{};
+        std::copy(first, last, values.begin());
+        for (int slot = 0; slot < length; slot += 4) {
+            compute(float_4::load(values.data() + slot), slot).store(values.data() + slot);
+        }
+        // The quantizer of the host (Arr) goes last, like on In<sup>x</sup>
+        const std::function<float(float)> f = this->getFloatValueFunction();
+        if (f) { std::transform(values.begin(), values.begin() + length, values.begin(), f); }
+        std::copy(values.begin(), values.begin() + length, first);
+    }
+    FloatIter transform(FloatIter first,
+                        FloatIter last,
+                        FloatIter out,
+                        int channel) const override
+    {
+        FloatIter end = std::copy(first, last, out);
+        transformInPlace(out, end, channel);
+        return end;
+    }
+};
@@ -0,0 +1,278 @@
+#include "MidiImport.hpp"
+#include <osdialog.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <utility>
+#include "Shared.hpp"
+
+namespace midiimport {
+namespace {
+/// @brief Reads big endian numbers from a file, within the bounds of the current chunk
+class Reader {
+   public:
+    explicit Reader(std::FILE* file) : file(file) {}
+    bool failed() const
+    {
+        return failure;
+    }
+    uint32_t left() const
+    {
+        return remaining;
+    }
+    /// @brief Starts a chunk of length bytes, reads beyond it fail
+    void enter(uint32_t length)
+    {
+        remaining = length;
+    }
+    uint8_t byte()
+    {
+        if (remaining == 0) {
+            failure = true;
+            return 0;
+        }
+        const int c = std::fgetc(file);
+        if (c == EOF) {
+            failure = true;
+            return 0;
+        }
+        --remaining;
+        return static_cast<uint8_t>(c);
+    }
+    uint32_t number(int bytes)
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < bytes; ++i) {
+            value = (value << 8U) | byte();
+        }
+        return value;
+    }
+    /// @brief A variable length quantity: 7 bits per byte, the high bit marks a following byte
+    uint32_t quantity()
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            const uint8_t b = byte();
+            value = (value << 7U) | (b & 0x7FU);
+            if ((b & 0x80U) == 0) { return value; }
+        }
+        failure = true;
+        return value;
+    }
+    void skip(uint32_t length)
+    {
+        if (length > remaining || std::fseek(file, length, SEEK_CUR) != 0) {
+            failure = true;
+            return;
+        }
+        remaining -= length;
+    }
+    /// @brief The id of the next chunk, false at the end of the file
+    bool chunk(std::array<char, 4>& id, uint32_t& length)
+    {
+        if (std::fread(id.data(), 1, id.size(), file) != id.size()) { return false; }
+        enter(sizeof(length));
+        length = number(sizeof(length));
+        return !failure;
+    }
+
+   private:
+    std::FILE* file;
+    uint32_t remaining = 0;
+    bool failure = false;
+};
+
+/// @brief Places note starts into the table, track by track
+class Placer {
+   public:
+    Placer(Table& table, uint32_t ticksPerQuarter)
+        : table(table), ticksPerQuarter(ticksPerQuarter), barTicks(ticksPerQuarter * 4)
+    {
+    }
+    /// @brief Bars follow the time signature only as long as no note was placed
+    void setTimeSignature(uint8_t numerator, uint8_t denominatorPower)
+    {
+        if (placed || numerator == 0 || denominatorPower > 6) { return; }
+        barTicks = std::max<uint32_t>(ticksPerQuarter * 4 * numerator >> denominatorPower, 1);
+    }
+    void place(uint32_t tick, uint8_t note)
+    {
+        placed = true;
+        const uint32_t bar = tick / barTicks;
+        if (bar >= static_cast<uint32_t>(NUM_PATTERNS - firstPattern)) { return; }
+        lastBar = std::max(lastBar, static_cast<int>(bar));
+        const uint64_t stepTicks = static_cast<uint64_t>(tick % barTicks) * STEPS;
+        const int index = (firstPattern + static_cast<int>(bar)) * STEPS +
+                          static_cast<int>(stepTicks / barTicks);
+        const float pitch = getVoctFromMidiNote(note);
+        table.pitches[index] = table.gates[index] ? std::min(table.pitches[index], pitch) : pitch;
+        table.gates[index] = true;
+    }
+    /// @brief Fills the steps without notes and moves on to the patterns of the next track
+    void endTrack()
+    {
+        if (lastBar < 0) { return; }
+        const int first = firstPattern * STEPS;
+        const int last = (firstPattern + lastBar + 1) * STEPS;
+        const auto begin = table.gates.begin();
+        float held = table.pitches[std::find(begin + first, begin + last, true) - begin];
+        for (int index = first; index < last; ++index) {
+            if (table.gates[index]) { held = table.pitches[index]; }
+            else {
+                table.pitches[index] = held;
+            }
+        }
+        firstPattern += lastBar + 1;
+        table.count = firstPattern;
+        lastBar = -1;
+    }
+
+   private:
+    Table& table;
+    uint32_t ticksPerQuarter;
+    uint32_t barTicks;
+    bool placed = false;
+    int firstPattern = 0;
+    /// @brief The last bar of the current track with a note, -1 for none
+    int lastBar = -1;
+};
+
+constexpr uint8_t META = 0xFF;
+constexpr uint8_t SYSEX = 0xF0;
+constexpr uint8_t SYSEX_ESCAPE = 0xF7;
+constexpr uint8_t META_END_OF_TRACK = 0x2F;
+constexpr uint8_t META_TIME_SIGNATURE = 0x58;
+constexpr uint8_t NOTE_ON = 0x90;
+constexpr uint8_t PROGRAM_CHANGE = 0xC0;
+constexpr uint8_t CHANNEL_PRESSURE = 0xD0;
+
+/// @return false when the track is malformed
+bool readTrack(Reader& reader, Placer& placer)
+{
+    uint32_t tick = 0;
+    uint8_t status = 0;
+    while (reader.left() > 0 && !reader.failed()) {
+        tick += reader.quantity();
+        uint8_t first = reader.byte();
+        if (first == META) {
+            const uint8_t type = reader.byte();
+            const uint32_t length = reader.quantity();
+            if (type == META_END_OF_TRACK) { break; }
+            if (type == META_TIME_SIGNATURE && length >= 2) {
+                const uint8_t numerator = reader.byte();
+                placer.setTimeSignature(numerator, reader.byte());
+                reader.skip(length - 2);
+            }
+            else {
+                reader.skip(length);
+            }
+            continue;
+        }
+        if (first == SYSEX || first == SYSEX_ESCAPE) {
+            reader.skip(reader.quantity());
+            status = 0;
+            continue;
+        }
+        // Without a status byte the previous one runs on
+        if (first & 0x80U) {
+            status = first;
+            first = reader.byte();
+        }
+        if (status < 0x80U || status >= SYSEX) { return false; }
+        const uint8_t kind = status & 0xF0U;
+        const bool oneDataByte = kind == PROGRAM_CHANGE || kind == CHANNEL_PRESSURE;
+        const uint8_t second = oneDataByte ? 0 : reader.byte();
+        if (kind == NOTE_ON && second > 0) { placer.place(tick, first & 0x7FU); }
+    }
+    // The rest of the chunk, after the end of track
+    reader.skip(reader.left());
+    placer.endTrack();
+    return !reader.failed();
+}
+}  // namespace
+
+std::string parse(const std::string& path, Table& table)
+{
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> file(std::fopen(path.c_str(), "rb"),
+                                                         &std::fclose);
+    if (!file) { return "Can't open " + path; }
+    Reader reader(file.get());
+    std::array<char, 4> id{};
+    uint32_t length = 0;
+    if (!reader.chunk(id, length) || id != std::array<char, 4>{'M', 'T', 'h', 'd'} ||
+        length < 6) {
+        return "Not a MIDI file";
+    }
+    reader.enter(length);
+    reader.number(2);  // Format, all of them are read track after track
+    reader.number(2);  // Number of tracks, the chunks tell
+    const uint32_t division = reader.number(2);
+    reader.skip(reader.left());
+    if (reader.failed()) { return "Not a MIDI file"; }
+    if ((division & 0x8000U) != 0 || division == 0) {
+        return "MIDI files with SMPTE timing can't be imported";
+    }
+    Placer placer(table, division);
+    while (reader.chunk(id, length)) {
+        reader.enter(length);
+        if (id != std::array<char, 4>{'M', 'T', 'r', 'k'}) {
+            reader.skip(length);
+        }
+        else if (!readTrack(reader, placer)) {
+            return "The MIDI file is damaged";
+        }
+        if (reader.failed()) { return "The MIDI file is damaged"; }
+    }
+    if (table.count == 0) { return "No notes in the MIDI file"; }
+    return {};
+}
+
+Importer::~Importer()
+{
+    if (worker.joinable()) { worker.join(); }
+    delete finished.load();
+    delete applied.load();
+}
+
+bool Importer::start(const std::string& path)
+{
+    if (isRunning()) { return false; }
+    if (worker.joinable()) { worker.join(); }
+    running.store(true, std::memory_order_release);
+    worker = std::thread([this, path]() {
+        auto table = std::make_unique<Table>();
+        error = parse(path, *table);
+        // A table the engine didn't take yet is replaced
+        if (error.empty()) { delete finished.exchange(table.release(), std::memory_order_acq_rel); }
+        running.store(false, std::memory_order_release);
+    });
+    return true;
+}
+
+void Importer::poll()
+{
+    delete applied.exchange(nullptr, std::memory_order_acquire);
+    if (!worker.joinable() || isRunning()) { return; }
+    worker.join();
+    if (!error.empty()) {
+        osdialog_message(OSDIALOG_WARNING, OSDIALOG_OK, std::exchange(error, {}).c_str());
+    }
+}
+
+rack::ui::MenuItem* createImportMenuItem(Importer& importer)
+{
+    return rack::createMenuItem(
+        "Import MIDI…", importer.isRunning() ? "Importing" : "",
+        [&importer]() {
+            osdialog_filters* filters = osdialog_filters_parse("MIDI file:mid,midi");
+            char* path = osdialog_file(OSDIALOG_OPEN, nullptr, nullptr, filters);
+            osdialog_filters_free(filters);
+            if (!path) { return; }
+            importer.start(path);
+            std::free(path);  // NOLINT
+        },
+        importer.isRunning());
+}
+}  // namespace midiimport
@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <rack.hpp>
+#include <string>
+#include <thread>
+#include "constants.hpp"
+
+/// @brief Imports the notes of a Standard MIDI File into stored patterns
+/// @details Every bar of every track with notes becomes a pattern of 16 steps: the bars of the
+/// first track, then those of the next one. A step is on when a note starts in it, its pitch is
+/// the lowest note starting in it and steps without a note hold the previous pitch. Bars are
+/// counted in the time signature at the start of the file, 4/4 without one.
+namespace midiimport {
+constexpr int NUM_PATTERNS = constants::NUM_PATTERNS;
+constexpr int STEPS = constants::MAX_STEPS;
+
+/// @brief The imported patterns, allocated once by the worker thread
+struct Table {
+    int count = 0;
+    std::array<float, NUM_PATTERNS * STEPS> pitches{};
+    std::array<bool, NUM_PATTERNS * STEPS> gates{};
+
+    const float* pitchPattern(int index) const
+    {
+        return pitches.data() + index * STEPS;
+    }
+    const bool* gatePattern(int index) const
+    {
+        return gates.data() + index * STEPS;
+    }
+};
+
+/// @brief Reads path into table, one event at a time without loading the file
+/// @return An error message, empty on success
+std::string parse(const std::string& path, Table& table);
+
+/// @brief Runs imports on a worker thread and hands the result to the engine thread
+/// @details The worker publishes the finished table with an atomic swap, the engine thread
+/// copies it into its patterns and hands it back. The UI thread frees it in poll(), so the
+/// engine thread neither parses nor (de)allocates.
+class Importer {
+   public:
+    Importer() = default;
+    ~Importer();
+    Importer(const Importer&) = delete;
+    Importer& operator=(const Importer&) = delete;
+
+    /// @brief UI thread: imports path on the worker thread
+    /// @return false while the previous import is still running
+    bool start(const std::string& path);
+    bool isRunning() const
+    {
+        return running.load(std::memory_order_acquire);
+    }
+    /// @brief UI thread, every frame: frees applied tables and reports errors of the worker
+    void poll();
+    /// @brief Engine thread: a finished import to apply, nullptr for none
+    const Table* acquire()
+    {
+        return finished.exchange(nullptr, std::memory_order_acq_rel);
+    }
+    /// @brief Engine thread: hands an applied table back to be freed
+    void release(const Table* table)
+    {
+        applied.store(table, std::memory_order_release);
+    }
+
+   private:
+    std::thread worker;
+    std::atomic<bool> running{false};
+    /// @brief Written by the worker before running is cleared
+    std::string error;
+    std::atomic<Table*> finished{nullptr};
+    std::atomic<const Table*> applied{nullptr};
+};
+
+/// @brief Menu item that asks for a MIDI file and imports it
+rack::ui::MenuItem* createImportMenuItem(Importer& importer);
+}  // namespace midiimport
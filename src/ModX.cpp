@@ -12,11 +12,14 @@ ModX::ModX() : biexpand::BiExpander(false)
     configInput(INPUT_PROB, "Randomness");
 
     configInput(INPUT_REPS, "Repetitions");
-    configParam(PARAM_REP_DUR, 0.F, 1.F, .5F, "Repetition duration", "%", 0.F, 100.F);
+    configParam<biexpand::CachedParamQuantity<>>(PARAM_REP_DUR, 0.F, 1.F, .5F,
+                                                 "Repetition duration", "%", 0.F, 100.F);
 
     configInput(INPUT_GLIDE, "Glides");
-    configParam(PARAM_GLIDE_TIME, 0.F, 1.F, .5F, "Glide time", " %", 0.F, 100.F);
-    configParam<sp::ShapeQuantity>(PARAM_GLIDE_SHAPE, -1.F, 1.F, 0.F, "Glide shape", "");
+    configParam<biexpand::CachedParamQuantity<>>(PARAM_GLIDE_TIME, 0.F, 1.F, .5F, "Glide time",
+                                                 " %", 0.F, 100.F);
+    configParam<biexpand::CachedParamQuantity<sp::ShapeQuantity>>(PARAM_GLIDE_SHAPE, -1.F, 1.F,
+                                                                  0.F, "Glide shape", "");
     configCache();
 };
 
@@ -29,6 +29,18 @@ class ModXAdapter : public biexpand::BaseAdapter<ModX> {
     {
         return true;
     }
+    bool canQuery() const override
+    {
+        return true;
+    }
+    bool reordersIndices(int /*inputLength*/, int /*channel*/) const override
+    {
+        return false;
+    }
+    uint16_t mapDirty(uint16_t dirty, int /*inputLength*/, int /*channel*/) const override
+    {
+        return dirty;
+    }
 
     ModParams getParams(int index) const
     {
@@ -9,8 +9,9 @@
 OutX::OutX() : biexpand::BiExpander(true)
 {
     config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
-    configSwitch(PARAM_NORMALLED, 0.0, 1.0, 1.0, "mode", {"Individual", "Normalled"});
-    configSwitch(PARAM_CUT, 0.0, 1.0, 0.0, "mode", {"Copy", "Cut"});
+    using CachedSwitch = biexpand::CachedParamQuantity<SwitchQuantity>;
+    configSwitch<CachedSwitch>(PARAM_NORMALLED, 0.0, 1.0, 1.0, "mode", {"Individual", "Normalled"});
+    configSwitch<CachedSwitch>(PARAM_CUT, 0.0, 1.0, 0.0, "mode", {"Copy", "Cut"});
     configCache();
 }
 
@@ -24,6 +25,16 @@ void OutX::process(const ProcessArgs& /*args*/)
     }
 }
 
+void OutX::onPortChange(const PortChangeEvent& e)
+{
+    BiExpander::onPortChange(e);
+    if (e.type != Port::OUTPUT) { return; }
+    if (e.connecting) { connectedMask |= 1U << e.portId; }
+    else {
+        connectedMask &= ~(1U << e.portId);
+    }
+}
+
 bool OutxAdapter::writeGateVoltage(int port, bool gateOn, int channel)
 {
     if (!ptr) { return false; }
@@ -35,19 +46,14 @@ bool OutxAdapter::writeGateVoltage(int port, bool gateOn, int channel)
         lastPort[channel] = port;
     }
     if (!ptr->getNormalledMode()) {
-        if (ptr->outputs[port].isConnected()) {
-            ptr->outputs[port].setVoltage(gateOn * 10.F, channel);
-        }
+        if (isConnected(port)) { ptr->outputs[port].setVoltage(gateOn * 10.F, channel); }
         return ptr->getCutMode();
     }
     // Normalled mode
-    for (int portIdx = port; portIdx < 16; portIdx++) {
-        if (ptr->outputs[portIdx].isConnected()) {
-            ptr->outputs[portIdx].setVoltage(gateOn * 10.F, channel);
-            return ptr->getCutMode();
-        }
-    }
-    return false;
+    const int portIdx = getFirstConnectedIndex(port);
+    if (portIdx == -1) { return false; }
+    ptr->outputs[portIdx].setVoltage(gateOn * 10.F, channel);
+    return ptr->getCutMode();
 }
 
 /// @brief report how many items will be cut
@@ -55,11 +61,7 @@ int OutxAdapter::totalConnected(int /*channel*/) const
 {
     if (!ptr) { return 0; }
     if (ptr->getNormalledMode()) { return getLastConnectedIndex(); }
-    int count = 0;
-    for (int i = 0; i < 16; i++) {
-        if (ptr->outputs[i].isConnected()) { count++; }
-    }
-    return count;
+    return std::popcount(ptr->getConnectedMask());
 }
 using namespace dimensions;  // NOLINT
 struct OutXWidget : public SIMWidget {
@@ -1,7 +1,8 @@
 #pragma once
-// SOMEDAYMAYBE: make outx multichannel aware. For now it's just 1 channel
 #include <algorithm>
 #include <array>
+#include <bit>
+#include <cstdint>
 #include <iterator>
 #include <rack.hpp>
 #include "biexpander/biexpander.hpp"
@@ -19,6 +20,13 @@ struct OutX : public biexpand::BiExpander {
 
     OutX();
     void process(const ProcessArgs& args) override;
+    void onPortChange(const PortChangeEvent& e) override;
+
+    /// @brief Bit i is set when output i is connected. Updated on port change only.
+    uint16_t getConnectedMask() const
+    {
+        return connectedMask;
+    }
 
     bool getCutMode() const
     {
@@ -33,12 +41,10 @@ struct OutX : public biexpand::BiExpander {
     /// @brief Used by by our friend the widget to draw the segment2x8 when normalled
     int getLastNormalledPortIndex()
     {
-        if (!getNormalledMode()) { return -1; }
-        for (int i = constants::NUM_CHANNELS - 1; i >= 0; i--) {
-            if (outputs[i].isConnected()) { return i + 1; }
-        }
-        return -1;
+        if (!getNormalledMode() || !connectedMask) { return -1; }
+        return std::bit_width(connectedMask);
     }
+    uint16_t connectedMask = 0;
 };
 
 class OutxAdapter : public biexpand::BaseAdapter<OutX> {
@@ -49,47 +55,159 @@ class OutxAdapter : public biexpand::BaseAdapter<OutX> {
         assert(ptr);
         assert(std::distance(first, last) <= 16);
         const int inputCount = std::distance(first, last);
+        // Scale and offset the whole buffer at once, ports then just copy from it
+        alignas(16) std::array<float, constants::MAX_STEPS> scaled{};
+        std::copy(first, last, scaled.begin());
+        scaleOffset(scaled.data(), multiplyFactor, offset);
+        const uint16_t connected = ptr->getConnectedMask();
 
         if (ptr->getNormalledMode()) {
             // DOCUMENT: Normalled mode we use the channels so we have to ignore channel
-            // Note that argument memory of first is being used
-            // if we don't the output (visually) glitches
-            auto copyFrom = first;
-            for (auto& output : ptr->outputs) {
-                if (output.isConnected()) {
-                    if (copyFrom >= last) {
-                        // set remaining ports to 0
-                        output.setChannels(0);
-                        output.setVoltage(0.F);
-                        continue;
-                    }
-                    int channels = std::distance(copyFrom, first) + 1;
-                    output.setChannels(clamp(channels, 1, inputCount));
-                    std::transform(
-                        copyFrom, copyFrom + channels,
-                        iters::PortVoltageIterator(output.getVoltages()),
-                        [multiplyFactor, offset](float v) { return v * multiplyFactor + offset; });
-                    copyFrom = first + 1;
+            // Each connected port gets the values from the previous connected port up to its own
+            int copyFrom = 0;
+            for (uint16_t mask = connected; mask; mask &= mask - 1) {
+                const int port = std::countr_zero(mask);
+                auto& output = ptr->outputs[port];
+                if (copyFrom >= inputCount) {
+                    // set remaining ports to 0
+                    output.setChannels(0);
+                    output.setVoltage(0.F);
+                    continue;
                 }
-                ++first;
+                const int channels = clamp(port - copyFrom + 1, 1, inputCount);
+                output.setChannels(channels);
+                std::copy_n(scaled.begin() + copyFrom, channels, output.getVoltages());
+                copyFrom = port + 1;
             }
             return;
         }
-        int i = 0;
-        for (auto it = first; it != last; ++it, i++) {
-            if (ptr->outputs[i].isConnected()) {
-                ptr->outputs[i].setVoltage(*it * multiplyFactor + offset);
-                ptr->outputs[i].setChannels(1);
-                // For now we do outx just 1 channel. Making it multi is easy, but for phi->outx
-                // makes no sense
-            }
+        const uint16_t inRange = (1U << inputCount) - 1U;
+        for (uint16_t mask = connected & inRange; mask; mask &= mask - 1) {
+            const int port = std::countr_zero(mask);
+            ptr->outputs[port].setVoltage(scaled[port]);
+            ptr->outputs[port].setChannels(1);
         }
         // set remaining ports to 0
-        for (; i < 16; i++) {
+        for (int i = inputCount; i < constants::NUM_CHANNELS; i++) {
             ptr->outputs[i].setVoltage(0.F);
             ptr->outputs[i].setChannels(0);
         }
     }
+    /// @brief Polyphonic fan-out of a poly chain: each port carries its step for every channel
+    /// @param portValues Transposed chain buffers: portValues[port * MAX_STEPS + channel]
+    /// @param portChannels Bit c of portChannels[port] is set when channel c has a step at port
+    /// @details Ports beyond the end of the buffer of a channel output 0V on that channel.
+    /// Normalled mode spreads steps over channels, so there only chain channel 0 is written.
+    void writePoly(const float* portValues,
+                   const std::array<uint16_t, constants::MAX_STEPS>& portChannels,
+                   int channels,
+                   float multiplyFactor = 1.0F,
+                   float offset = 0.F)
+    {
+        assert(ptr);
+        if (ptr->getNormalledMode()) {
+            std::array<float, constants::MAX_STEPS> steps{};
+            int length = 0;
+            while (length < constants::MAX_STEPS && (portChannels[length] & 1U)) {
+                steps[length] = portValues[length * constants::MAX_STEPS];
+                length++;
+            }
+            write(steps.begin(), steps.begin() + length, multiplyFactor, offset);
+            return;
+        }
+        const uint16_t connected = ptr->getConnectedMask();
+        const uint32_t activeChannels = (1U << channels) - 1U;
+        for (int port = 0; port < constants::NUM_CHANNELS; port++) {
+            auto& output = ptr->outputs[port];
+            if (!(connected & (1U << port)) || !(portChannels[port] & activeChannels)) {
+                output.setVoltage(0.F);
+                output.setChannels(0);
+                continue;
+            }
+            output.setChannels(channels);
+            const float* values = portValues + port * constants::MAX_STEPS;
+            for (int c = 0; c < channels; c += 4) {
+                simd::float_4 v =
+                    simd::float_4::load(values + c) * multiplyFactor + offset;
+                v.store(output.getVoltages(c));
+            }
+        }
+    }
+
+    /// @brief Rewrites only the ports showing an element in dirty, see write()
+    template <typename Iter>
+    void writeChanged(Iter first, Iter last, uint16_t dirty)
+    {
+        assert(ptr);
+        const int inputCount = std::distance(first, last);
+        if (ptr->getNormalledMode()) {
+            // An element shows up at the first connected port at or after its index
+            uint16_t ports = 0;
+            for (uint16_t mask = dirty; mask; mask &= mask - 1) {
+                const int port = getFirstConnectedIndex(std::countr_zero(mask));
+                if (port == -1) { break; }
+                ports |= 1U << port;
+            }
+            int copyFrom = 0;
+            for (uint16_t mask = ptr->getConnectedMask(); mask; mask &= mask - 1) {
+                const int port = std::countr_zero(mask);
+                if (copyFrom >= inputCount) { break; }
+                if (ports & (1U << port)) {
+                    const int channels = std::min(port + 1, inputCount) - copyFrom;
+                    std::copy_n(first + copyFrom, channels, ptr->outputs[port].getVoltages());
+                }
+                copyFrom = port + 1;
+            }
+            return;
+        }
+        const uint16_t inRange = (1U << inputCount) - 1U;
+        for (uint16_t mask = dirty & inRange & ptr->getConnectedMask(); mask; mask &= mask - 1) {
+            const int port = std::countr_zero(mask);
+            ptr->outputs[port].setVoltage(*(first + port));
+        }
+    }
+
+    bool canQuery() const override
+    {
+        return ptr != nullptr;
+    }
+    /// @brief Cut turns gates off and keeps the length, which the queries below don't model
+    bool canQueryGates() const override
+    {
+        return ptr && !ptr->getCutMode();
+    }
+    /// @brief Cut removes the elements shown by connected ports
+    int queryLength(int inputLength, int channel) const override
+    {
+        if (inPlace(inputLength, channel)) { return inputLength; }
+        const int lastConnected = getLastConnectedIndex();
+        if (lastConnected == -1) { return inputLength; }
+        if (ptr->getNormalledMode()) { return std::max(inputLength - (lastConnected + 1), 0); }
+        const uint16_t cut = ptr->getConnectedMask() & ((1U << inputLength) - 1U);
+        return inputLength - std::popcount(cut);
+    }
+    int querySource(int index, int inputLength, int channel) const override
+    {
+        if (inPlace(inputLength, channel)) { return index; }
+        const int lastConnected = getLastConnectedIndex();
+        if (lastConnected == -1) { return index; }
+        if (ptr->getNormalledMode()) { return index + lastConnected + 1; }
+        // The index-th element without a connected port
+        uint16_t uncut = ~ptr->getConnectedMask();
+        for (int i = 0; i < index; ++i) {
+            uncut &= uncut - 1;
+        }
+        return std::countr_zero(uncut);
+    }
+    bool reordersIndices(int inputLength, int channel) const override
+    {
+        return !inPlace(inputLength, channel) && getLastConnectedIndex() != -1;
+    }
+    uint16_t mapDirty(uint16_t dirty, int inputLength, int channel) const override
+    {
+        if (ptr->cacheState.getChangedParams()) { return ALL_INDICES; }
+        return mapDirtyBySource(dirty, inputLength, channel);
+    }
 
     bool inPlace(int /*length*/, int /*channel*/) const override
     {
@@ -109,13 +227,10 @@ class OutxAdapter : public biexpand::BaseAdapter<OutX> {
         // When using a boolIter with cut we just false the bool and leave the length as is
         const bool normalled = ptr->getNormalledMode();
         if (!normalled) {
-            auto output = iters::PortIterator<Output>(ptr->outputs.begin());
+            uint16_t connected = ptr->getConnectedMask();
             for (auto it = first; it != last; ++it) {
-                if (output->isConnected()) { *out = false; }
-                else {
-                    *out = *it;
-                }
-                ++output;
+                *out = (connected & 1U) ? false : static_cast<bool>(*it);
+                connected >>= 1;
                 ++out;
             };
             return out;
@@ -154,12 +269,11 @@ class OutxAdapter : public biexpand::BaseAdapter<OutX> {
 
         // Not normalled and cut. Itereate and leave out the connections
         if (!normalled) {  // not normalled
-            auto outIt = iters::PortIterator<Output>(ptr->outputs.begin());
-            auto predicate = [/*&channel, */ &outIt](auto /*v*/) {
-                bool exclude = outIt->isConnected();
-                ++outIt;
+            uint16_t connected = ptr->getConnectedMask();
+            auto predicate = [&connected](auto /*v*/) {
+                const bool exclude = connected & 1U;
+                connected >>= 1;
                 return !exclude;
-                ;
             };
             return std::copy_if(first, last, out, predicate);
         }
@@ -181,13 +295,13 @@ class OutxAdapter : public biexpand::BaseAdapter<OutX> {
     bool setVoltageCut(float voltage, int port, int channel = 0)
     {
         if (!ptr) { return false; }
-        if (!ptr->outputs[port].isConnected()) { return false; }
+        if (!isConnected(port)) { return false; }
         ptr->outputs[port].setVoltage(voltage, channel);
         return ptr->getCutMode();
     }
     bool isConnected(int port) const
     {
-        return ptr && ptr->outputs[port].isConnected();
+        return ptr && (ptr->getConnectedMask() & (1U << port));
     }
     bool setChannels(int channels, int port) const
     {
@@ -197,18 +311,13 @@ class OutxAdapter : public biexpand::BaseAdapter<OutX> {
     }
     int getLastConnectedIndex() const
     {
-        for (int i = constants::NUM_CHANNELS - 1; i >= 0; i--) {
-            if (ptr->outputs[i].isConnected()) { return i; }
-        }
-        return -1;
+        return std::bit_width(ptr->getConnectedMask()) - 1;
     }
 
     int getFirstConnectedIndex(int offset = 0) const
     {
-        for (int i = offset; i < constants::NUM_CHANNELS; i++) {
-            if (ptr->outputs[i].isConnected()) { return i; }
-        }
-        return -1;
+        const uint16_t connected = ptr->getConnectedMask() >> offset;
+        return connected ? offset + std::countr_zero(connected) : -1;
     }
 
     /// @brief reports the number of connected ports. If normalled, it returns the last connected
@@ -219,6 +328,13 @@ class OutxAdapter : public biexpand::BaseAdapter<OutX> {
     bool writeGateVoltage(int port, bool gateOn, int channel = 0);
 
    private:
+    /// @brief Multiplies and offsets MAX_STEPS floats in place, four at a time
+    static void scaleOffset(float* values, float multiplyFactor, float offset)
+    {
+        for (int i = 0; i < constants::MAX_STEPS; i += 4) {
+            (simd::float_4::load(values + i) * multiplyFactor + offset).store(values + i);
+        }
+    }
     /// @brief The last output index that was set to a non-zero value per channel
     // std::array<int, constants::NUM_CHANNELS> lastHigh = {};
     // used internally for resetting gates
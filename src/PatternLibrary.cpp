@@ -0,0 +1,405 @@
+#include "PatternLibrary.hpp"
+#include <osdialog.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#ifdef ARCH_WIN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace patlib {
+namespace {
+uint32_t recordSize(Type type)
+{
+    return type == Type::GATES ? sizeof(GateRecord) : sizeof(VoltageRecord);
+}
+
+/// @brief Modification time and size of path, false when it doesn't exist
+bool getStat(const std::string& path, int64_t& modified, int64_t& size)
+{
+    struct stat info {};
+    if (stat(path.c_str(), &info) != 0) { return false; }
+    modified = static_cast<int64_t>(info.st_mtime);
+    size = static_cast<int64_t>(info.st_size);
+    return true;
+}
+
+std::string getFilename(const std::string& path)
+{
+    const size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+/// @brief Whether the size of path covers the records its header announces
+/// @details False for files that are not libraries, those are reported by Mapping::open().
+bool isComplete(const std::string& path, int64_t size)
+{
+    std::ifstream file(path, std::ios::binary);
+    Header header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) { return false; }  // NOLINT
+    return size >= static_cast<int64_t>(sizeof(header) +
+                                        static_cast<uint64_t>(header.count) * header.recordSize);
+}
+
+#ifndef ARCH_WIN
+/// @brief Copies the file from into a temporary file that is already unlinked
+/// @return The descriptor of the copy, -1 on failure
+int copyToPrivateFile(int from)
+{
+    std::string name = rack::asset::user("SIM-library-XXXXXX");
+    const int to = mkstemp(name.data());
+    if (to < 0) { return -1; }
+    unlink(name.c_str());
+    std::array<char, 1 << 16> buffer{};
+    ssize_t count = 0;
+    while ((count = ::read(from, buffer.data(), buffer.size())) > 0) {
+        if (::write(to, buffer.data(), count) != count) {
+            count = -1;
+            break;
+        }
+    }
+    if (count < 0) {
+        ::close(to);
+        return -1;
+    }
+    return to;
+}
+#endif
+
+using Pattern = std::vector<float>;
+
+bool readCsv(const std::string& from, std::vector<Pattern>& patterns, std::string& error)
+{
+    std::ifstream file(from);
+    if (!file) {
+        error = "Can't open " + from;
+        return false;
+    }
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        std::replace_if(
+            line.begin(), line.end(), [](char c) { return c == ',' || c == ';' || c == '\t'; },
+            ' ');
+        std::istringstream values(line);
+        std::string value;
+        Pattern pattern;
+        while (values >> value) {
+            if (pattern.empty() && value[0] == '#') { break; }
+            char* end = nullptr;
+            const float number = std::strtof(value.c_str(), &end);
+            if (*end != '\0') {
+                error = "Line " + std::to_string(lineNumber) + ": '" + value + "' is not a number";
+                return false;
+            }
+            pattern.push_back(number);
+        }
+        if (!pattern.empty()) { patterns.push_back(std::move(pattern)); }
+    }
+    return true;
+}
+
+bool readJson(const std::string& from, std::vector<Pattern>& patterns, std::string& error)
+{
+    json_error_t jsonError;
+    json_t* rootJ = json_load_file(from.c_str(), 0, &jsonError);
+    if (!rootJ) {
+        error = "Line " + std::to_string(jsonError.line) + ": " + jsonError.text;
+        return false;
+    }
+    json_t* patternsJ = json_is_object(rootJ) ? json_object_get(rootJ, "patterns") : rootJ;
+    const bool valid = json_is_array(patternsJ);
+    if (valid) {
+        for (size_t index = 0; index < json_array_size(patternsJ); ++index) {
+            json_t* patternJ = json_array_get(patternsJ, index);
+            Pattern pattern;
+            for (size_t step = 0; step < json_array_size(patternJ); ++step) {
+                json_t* valueJ = json_array_get(patternJ, step);
+                pattern.push_back(json_is_boolean(valueJ)
+                                      ? (json_is_true(valueJ) ? 1.F : 0.F)
+                                      : static_cast<float>(json_number_value(valueJ)));
+            }
+            patterns.push_back(std::move(pattern));
+        }
+    }
+    else {
+        error = "Expected an array of patterns";
+    }
+    json_decref(rootJ);
+    return valid;
+}
+
+bool writeLibrary(const std::string& to,
+                  const std::vector<Pattern>& patterns,
+                  Type type,
+                  std::string& error)
+{
+    const std::string temporary = to + ".tmp";
+    FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) {
+        error = "Can't write " + temporary;
+        return false;
+    }
+    Header header{MAGIC, VERSION, type, static_cast<uint32_t>(patterns.size()), recordSize(type),
+                  {}};
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    for (const Pattern& pattern : patterns) {
+        const auto length = static_cast<uint8_t>(pattern.size());
+        if (type == Type::GATES) {
+            GateRecord record{0, length, 0};
+            for (int step = 0; step < length; ++step) {
+                if (pattern[step] > 0.F) { record.mask |= 1U << step; }
+            }
+            written = written && std::fwrite(&record, sizeof(record), 1, file) == 1;
+        }
+        else {
+            VoltageRecord record{{}, length, {}};
+            std::copy(pattern.begin(), pattern.end(), record.values.begin());
+            written = written && std::fwrite(&record, sizeof(record), 1, file) == 1;
+        }
+    }
+    written = std::fclose(file) == 0 && written;
+#ifdef ARCH_WIN
+    // rename() doesn't replace files on Windows
+    std::remove(to.c_str());
+#endif
+    if (!written || std::rename(temporary.c_str(), to.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        error = "Can't write " + to;
+        return false;
+    }
+    return true;
+}
+}  // namespace
+
+std::unique_ptr<const Mapping> Mapping::open(const std::string& path,
+                                             Type type,
+                                             std::string& error)
+{
+    std::unique_ptr<Mapping> mapping(new Mapping());
+#ifdef ARCH_WIN
+    // Without FILE_SHARE_WRITE nobody can truncate or rewrite the file while it is mapped
+    mapping->file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (mapping->file == INVALID_HANDLE_VALUE) {
+        mapping->file = nullptr;
+        error = "Can't open " + path;
+        return nullptr;
+    }
+    LARGE_INTEGER size;
+    GetFileSizeEx(mapping->file, &size);
+    mapping->length = static_cast<size_t>(size.QuadPart);
+    if (mapping->length > 0) {
+        mapping->fileMapping =
+            CreateFileMappingA(mapping->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    if (mapping->fileMapping) {
+        mapping->data = static_cast<const uint8_t*>(
+            MapViewOfFile(mapping->fileMapping, FILE_MAP_READ, 0, 0, 0));
+    }
+#else
+    const int original = ::open(path.c_str(), O_RDONLY);
+    if (original < 0) {
+        error = "Can't open " + path;
+        return nullptr;
+    }
+    // Reading a mapped file that is truncated or rewritten in place raises SIGBUS, so the
+    // mapping is of a copy nobody else can reach
+    const int file = copyToPrivateFile(original);
+    ::close(original);
+    if (file < 0) {
+        error = "Can't copy " + path;
+        return nullptr;
+    }
+    struct stat info {};
+    if (fstat(file, &info) == 0 && info.st_size > 0) {
+        mapping->length = static_cast<size_t>(info.st_size);
+        void* data = mmap(nullptr, mapping->length, PROT_READ, MAP_SHARED, file, 0);
+        if (data != MAP_FAILED) { mapping->data = static_cast<const uint8_t*>(data); }
+    }
+    // The mapping keeps the copy, it is freed with it
+    ::close(file);
+#endif
+    if (!mapping->data) {
+        error = "Can't map " + path;
+        return nullptr;
+    }
+    Header header{};
+    if (mapping->length < sizeof(header)) {
+        error = getFilename(path) + " is not a pattern library";
+        return nullptr;
+    }
+    std::memcpy(&header, mapping->data, sizeof(header));
+    if (header.magic != MAGIC || header.version != VERSION) {
+        error = getFilename(path) + " is not a pattern library";
+        return nullptr;
+    }
+    if (header.type != type || header.recordSize != recordSize(type)) {
+        error = getFilename(path) + (type == Type::GATES ? " doesn't hold gate patterns"
+                                                         : " doesn't hold voltage patterns");
+        return nullptr;
+    }
+    if (header.count == 0 ||
+        mapping->length < sizeof(header) + static_cast<size_t>(header.count) * header.recordSize) {
+        error = getFilename(path) + " is empty or incomplete";
+        return nullptr;
+    }
+    mapping->records = mapping->data + sizeof(header);
+    mapping->count = static_cast<int>(std::min<uint32_t>(header.count, INT32_MAX));
+    return mapping;
+}
+
+Mapping::~Mapping()
+{
+#ifdef ARCH_WIN
+    if (data) { UnmapViewOfFile(data); }
+    if (fileMapping) { CloseHandle(fileMapping); }
+    if (file) { CloseHandle(file); }
+#else
+    if (data) { munmap(const_cast<uint8_t*>(data), length); }  // NOLINT
+#endif
+}
+
+Library::~Library()
+{
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    if (watcher.joinable()) { watcher.join(); }
+    // The module is out of the engine by now
+    delete published.load();
+}
+
+bool Library::load(const std::string& path, std::string& error)
+{
+    std::unique_ptr<const Mapping> mapping = Mapping::open(path, type, error);
+    if (!mapping) { return false; }
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        this->path = path;
+        getStat(path, modified, fileSize);
+        publish(std::move(mapping));
+    }
+    if (!watcher.joinable()) { watcher = std::thread([this]() { watch(); }); }
+    return true;
+}
+
+void Library::unload()
+{
+    const std::lock_guard<std::mutex> lock(mutex);
+    path.clear();
+    publish(nullptr);
+}
+
+void Library::watch()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wake.wait_for(lock, POLL_INTERVAL, [this]() { return stopping; })) {
+        // A retired mapping that isn't pinned can't be picked up by acquire() anymore
+        const Mapping* inUse = pinned.load();
+        retired.erase(std::remove_if(retired.begin(), retired.end(),
+                                     [inUse](const std::unique_ptr<const Mapping>& mapping) {
+                                         return mapping.get() != inUse;
+                                     }),
+                      retired.end());
+        remap();
+    }
+}
+
+void Library::remap()
+{
+    if (path.empty()) { return; }
+    int64_t newModified = 0;
+    int64_t newSize = 0;
+    if (!getStat(path, newModified, newSize)) { return; }
+    if (newModified == modified && newSize == fileSize) { return; }
+    // A file that is still being written is tried again on the next poll
+    if (!isComplete(path, newSize)) { return; }
+    modified = newModified;
+    fileSize = newSize;
+    std::string error;
+    std::unique_ptr<const Mapping> mapping = Mapping::open(path, type, error);
+    if (mapping) { publish(std::move(mapping)); }
+}
+
+void Library::publish(std::unique_ptr<const Mapping> mapping)
+{
+    const Mapping* previous = published.exchange(mapping.release());
+    if (previous) { retired.emplace_back(previous); }
+}
+
+std::string convert(const std::string& from, const std::string& to, Type type)
+{
+    std::string error;
+    std::vector<Pattern> patterns;
+    const std::string filename = getFilename(from);
+    std::string extension = filename.substr(std::min(filename.find_last_of('.'), filename.size()));
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    const bool read = extension == ".json" ? readJson(from, patterns, error)
+                                           : readCsv(from, patterns, error);
+    if (!read) { return error; }
+    if (patterns.empty()) { return "No patterns in " + filename; }
+    for (size_t index = 0; index < patterns.size(); ++index) {
+        if (patterns[index].empty() || patterns[index].size() > constants::MAX_STEPS) {
+            return "Pattern " + std::to_string(index + 1) + " doesn't have 1 to 16 values";
+        }
+    }
+    if (!writeLibrary(to, patterns, type, error)) { return error; }
+    return {};
+}
+
+rack::ui::MenuItem* createLibraryMenuItem(Library& library)
+{
+    const std::string loaded =
+        library.getPath().empty() ? "None" : getFilename(library.getPath());
+    return rack::createSubmenuItem("Pattern library", loaded, [&library](rack::Menu* menu) {
+        const std::string filter = std::string("SIM pattern library:") + (EXTENSION + 1);
+        menu->addChild(rack::createMenuItem("Load…", "", [&library, filter]() {
+            osdialog_filters* filters = osdialog_filters_parse(filter.c_str());
+            char* path = osdialog_file(OSDIALOG_OPEN, nullptr, nullptr, filters);
+            osdialog_filters_free(filters);
+            if (!path) { return; }
+            std::string error;
+            if (!library.load(path, error)) {
+                osdialog_message(OSDIALOG_WARNING, OSDIALOG_OK, error.c_str());
+            }
+            std::free(path);  // NOLINT
+        }));
+        menu->addChild(rack::createMenuItem("Convert CSV/JSON…", "", [&library, filter]() {
+            osdialog_filters* sourceFilters = osdialog_filters_parse("CSV or JSON:csv,txt,json");
+            char* from = osdialog_file(OSDIALOG_OPEN, nullptr, nullptr, sourceFilters);
+            osdialog_filters_free(sourceFilters);
+            if (!from) { return; }
+            const std::string source = from;
+            std::free(from);  // NOLINT
+            const std::string stem = getFilename(source);
+            const std::string name = stem.substr(0, stem.find_last_of('.')) + EXTENSION;
+            osdialog_filters* filters = osdialog_filters_parse(filter.c_str());
+            char* to = osdialog_file(OSDIALOG_SAVE, nullptr, name.c_str(), filters);
+            osdialog_filters_free(filters);
+            if (!to) { return; }
+            const std::string target = to;
+            std::free(to);  // NOLINT
+            std::string error = convert(source, target, library.getType());
+            if (error.empty()) { library.load(target, error); }
+            if (!error.empty()) {
+                osdialog_message(OSDIALOG_WARNING, OSDIALOG_OK, error.c_str());
+            }
+        }));
+        menu->addChild(rack::createMenuItem(
+            "Unload", "", [&library]() { library.unload(); }, library.getPath().empty()));
+    });
+}
+}  // namespace patlib
@@ -0,0 +1,191 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <rack.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+#include "constants.hpp"
+
+/// @brief Pattern libraries: files of fixed size pattern records, read through a memory mapping
+/// @details A library holds any number of patterns of one type, voltages for Arr or gates for
+/// Bank. The pattern select CV picks a record by index, the audio thread reads it straight from
+/// the mapping without parsing or allocating. Libraries are made from CSV or JSON with
+/// convert(). All numbers are little endian, as on every platform Rack runs on.
+namespace patlib {
+enum class Type : uint32_t { VOLTAGES = 0, GATES = 1 };
+
+/// @brief The first 32 bytes of a library file, followed by count records
+struct Header {
+    std::array<char, 8> magic;
+    uint32_t version;
+    Type type;
+    uint32_t count;
+    uint32_t recordSize;
+    std::array<uint32_t, 2> reserved;
+};
+inline constexpr std::array<char, 8> MAGIC = {'S', 'I', 'M', 'P', 'L', 'I', 'B', '\0'};
+constexpr uint32_t VERSION = 1;
+
+/// @brief A voltage pattern: the values and how many of them are used
+struct VoltageRecord {
+    std::array<float, constants::MAX_STEPS> values;
+    uint8_t length;
+    std::array<uint8_t, 3> reserved;
+};
+/// @brief A gate pattern: step i is bit i of mask
+struct GateRecord {
+    uint16_t mask;
+    uint8_t length;
+    uint8_t reserved;
+};
+static_assert(sizeof(Header) == 32, "Header is part of the file format");
+static_assert(sizeof(VoltageRecord) == 68, "VoltageRecord is part of the file format");
+static_assert(sizeof(GateRecord) == 4, "GateRecord is part of the file format");
+
+constexpr const char* EXTENSION = ".simlib";
+
+/// @brief A library file mapped read only, checked once when it is opened
+class Mapping {
+   public:
+    /// @return nullptr when the file can't be mapped or isn't a library of type
+    static std::unique_ptr<const Mapping> open(const std::string& path,
+                                               Type type,
+                                               std::string& error);
+    ~Mapping();
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    int size() const
+    {
+        return count;
+    }
+    const VoltageRecord& voltages(int index) const
+    {
+        return reinterpret_cast<const VoltageRecord*>(records)[index];  // NOLINT
+    }
+    const GateRecord& gates(int index) const
+    {
+        return reinterpret_cast<const GateRecord*>(records)[index];  // NOLINT
+    }
+    /// @brief The record picked by the pattern select CV, 0V to 10V sweeps over all records
+    int recordAt(float voltage) const
+    {
+        return rack::clamp(static_cast<int>(voltage * (static_cast<float>(count) / 10.F)), 0,
+                           count - 1);
+    }
+
+   private:
+    Mapping() = default;
+    const uint8_t* data = nullptr;
+    size_t length = 0;
+    const uint8_t* records = nullptr;
+    int count = 0;
+#ifdef ARCH_WIN
+    void* file = nullptr;
+    void* fileMapping = nullptr;
+#endif
+};
+
+/// @brief The library of a module
+/// @details The UI thread (un)loads the library, a watcher thread started by the first load()
+/// checks the file for changes. A new mapping is published with an atomic swap, the engine
+/// thread pins it in pick(). A replaced mapping is unmapped by the watcher once it isn't pinned.
+class Library {
+   public:
+    explicit Library(Type type) : type(type) {}
+    ~Library();
+    Library(const Library&) = delete;
+    Library& operator=(const Library&) = delete;
+
+    Type getType() const
+    {
+        return type;
+    }
+    /// @brief UI thread
+    bool load(const std::string& path, std::string& error);
+    void unload();
+    /// @brief The loaded file, empty for none
+    const std::string& getPath() const
+    {
+        return path;
+    }
+    /// @brief Engine thread: pins the mapping for this sample and picks the record for the
+    /// pattern select CV, the first one while it isn't connected
+    /// @return true when another record (or none) is to be read
+    bool pick(rack::engine::Input& cv)
+    {
+        const Mapping* mapping = acquire();
+        int record = -1;
+        if (mapping) { record = cv.isConnected() ? mapping->recordAt(cv.getVoltage()) : 0; }
+        const bool picked = record != pickedRecord || mapping != pickedMapping;
+        pickedMapping = mapping;
+        pickedRecord = record;
+        return picked;
+    }
+    /// @brief Engine thread: the mapping of the last pick(), nullptr for none
+    const Mapping* getMapping() const
+    {
+        return pickedMapping;
+    }
+    /// @brief Engine thread: the record of the last pick()
+    int getRecord() const
+    {
+        return pickedRecord;
+    }
+
+   private:
+    static constexpr std::chrono::seconds POLL_INTERVAL{1};
+    Type type;
+    std::string path;
+    /// @brief Modification time and size of the file when it was mapped
+    int64_t modified = 0;
+    int64_t fileSize = 0;
+    std::atomic<const Mapping*> published{nullptr};
+    mutable std::atomic<const Mapping*> pinned{nullptr};
+    std::vector<std::unique_ptr<const Mapping>> retired;
+    const Mapping* pickedMapping = nullptr;
+    int pickedRecord = -1;
+    /// @brief Guards path, modified, fileSize and retired between the UI thread and the watcher
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread watcher;
+
+    /// @brief Engine thread: the mapping to use for this sample, nullptr for none
+    /// @details Pins the published mapping, then checks it is still the published one. Once it
+    /// is, the watcher sees the pin before it could free the mapping.
+    const Mapping* acquire() const
+    {
+        const Mapping* mapping = published.load();
+        while (mapping != pinned.load(std::memory_order_relaxed)) {
+            pinned.store(mapping);
+            mapping = published.load();
+        }
+        return mapping;
+    }
+    /// @brief Watcher thread: frees unpinned mappings and remaps the file after it changed,
+    /// every POLL_INTERVAL until the library is destroyed
+    void watch();
+    void remap();
+    void publish(std::unique_ptr<const Mapping> mapping);
+};
+
+/// @brief Converts patterns from CSV or JSON into a library file
+/// @details CSV: one pattern per line, values separated by commas, semicolons or spaces. Lines
+/// starting with # are skipped. JSON: an array of patterns, each an array of numbers (or
+/// booleans for gates), optionally under a "patterns" key. Patterns have 1 to 16 values, gates
+/// are on above 0. The file is written next to to and then renamed, so a mapped library is never
+/// changed under the engine thread.
+/// @return An error message, empty on success
+std::string convert(const std::string& from, const std::string& to, Type type);
+
+/// @brief Submenu to load, convert and unload the library of a module
+rack::ui::MenuItem* createLibraryMenuItem(Library& library);
+}  // namespace patlib
@@ -0,0 +1,173 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+#include <rack.hpp>
+#include "constants.hpp"
+
+/// @brief The stored patterns of Arr and Bank
+/// @details All patterns are kept in one contiguous array, pattern after pattern. The active
+/// pattern is a pointer into it, so switching patterns from the pattern select CV is a pointer
+/// swap on the audio thread. The patterns belong to the engine thread, the knobs (or buttons)
+/// only edit them through sync().
+/// @param T float for voltages, bool for gates
+template <typename T>
+class PatternMemory {
+   public:
+    static constexpr int NUM_PATTERNS = constants::NUM_PATTERNS;
+    static constexpr int STEPS = constants::MAX_STEPS;
+
+    T* active()
+    {
+        return current;
+    }
+    const T* active() const
+    {
+        return current;
+    }
+    T* pattern(int index)
+    {
+        return values.data() + index * STEPS;
+    }
+    /// @brief The pattern used while the pattern select CV is not connected
+    int getSelected() const
+    {
+        return selected;
+    }
+    void setSelected(int index)
+    {
+        selected = rack::clamp(index, 0, NUM_PATTERNS - 1);
+    }
+    int getActiveIndex() const
+    {
+        return static_cast<int>(active() - values.data()) / STEPS;
+    }
+    /// @brief Picks the active pattern, 0V to 10V at cv sweeps over all patterns
+    /// @return true when another pattern became active
+    bool process(rack::engine::Input& cv)
+    {
+        const int index =
+            cv.isConnected()
+                ? rack::clamp(static_cast<int>(cv.getVoltage() * (NUM_PATTERNS / 10.F)), 0,
+                              NUM_PATTERNS - 1)
+                : selected;
+        return activate(index);
+    }
+    /// @return true when another pattern became active
+    bool activate(int index)
+    {
+        T* next = pattern(index);
+        if (next == active()) { return false; }
+        current = next;
+        return true;
+    }
+    /// @brief Keeps the params and the active pattern in step
+    /// @details After a switch (or a load) the params show the new pattern. Otherwise a param
+    /// moved since the last call edits the pattern, and a step changed by the engine (an import)
+    /// moves its param. Call it when the params or the patterns may have changed.
+    /// @param params The STEPS params of the steps
+    /// @return Bitmask of the steps edited through the params
+    uint16_t sync(rack::engine::Param* params)
+    {
+        const int index = getActiveIndex();
+        T* steps = pattern(index);
+        const bool switched = std::exchange(shownPattern, index) != index;
+        uint16_t moved = 0;
+        for (int step = 0; step < STEPS; ++step) {
+            rack::engine::Param& param = params[step];
+            if (!switched && param.getValue() != shown[step]) {
+                steps[step] = fromParam(param.getValue());
+                moved |= 1U << step;
+            }
+            else if (toParam(steps[step]) != param.getValue()) {
+                param.setValue(toParam(steps[step]));
+            }
+            shown[step] = param.getValue();
+        }
+        return moved;
+    }
+    /// @brief Empties all patterns, the next sync() shows the active one on the params
+    void clear()
+    {
+        values.fill(T{});
+        shownPattern = -1;
+    }
+
+    /// @brief Voltages are stored as base64 packed floats, gates as one 16 bit mask per pattern
+    json_t* toJson() const
+    {
+        if constexpr (std::is_same_v<T, bool>) {
+            json_t* patternsJ = json_array();
+            for (int index = 0; index < NUM_PATTERNS; ++index) {
+                uint16_t mask = 0;
+                for (int step = 0; step < STEPS; ++step) {
+                    if (values[index * STEPS + step]) { mask |= 1U << step; }
+                }
+                json_array_append_new(patternsJ, json_integer(mask));
+            }
+            return patternsJ;
+        }
+        else {
+            return json_string(
+                rack::string::toBase64(reinterpret_cast<const uint8_t*>(values.data()),  // NOLINT
+                                       sizeof(values))
+                    .c_str());
+        }
+    }
+    void fromJson(json_t* patternsJ)
+    {
+        if constexpr (std::is_same_v<T, bool>) {
+            if (!json_is_array(patternsJ)) { return; }
+            const int count = std::min(static_cast<int>(json_array_size(patternsJ)), NUM_PATTERNS);
+            for (int index = 0; index < count; ++index) {
+                const auto mask =
+                    static_cast<uint16_t>(json_integer_value(json_array_get(patternsJ, index)));
+                for (int step = 0; step < STEPS; ++step) {
+                    values[index * STEPS + step] = mask & (1U << step);
+                }
+            }
+        }
+        else {
+            if (!json_is_string(patternsJ)) { return; }
+            const std::vector<uint8_t> bytes = rack::string::fromBase64(json_string_value(patternsJ));
+            std::memcpy(values.data(), bytes.data(), std::min(bytes.size(), sizeof(values)));
+        }
+    }
+
+   private:
+    std::array<T, NUM_PATTERNS * STEPS> values{};
+    T* current = values.data();
+    int selected = 0;
+    /// @brief The pattern and param values as of the last sync()
+    /// @details A new module shows the empty first pattern on params at their 0 default, so
+    /// params moved before the first sync() are edits as well
+    int shownPattern = 0;
+    std::array<float, STEPS> shown{};
+
+    static T fromParam(float value)
+    {
+        if constexpr (std::is_same_v<T, bool>) { return value > 0.F; }
+        else {
+            return value;
+        }
+    }
+    static float toParam(T value)
+    {
+        return static_cast<float>(value);
+    }
+};
+
+/// @brief Menu to pick the pattern used while the pattern select CV is not connected
+inline rack::ui::MenuItem* createPatternMenuItem(const std::function<int()>& getPattern,
+                                                 const std::function<void(int)>& setPattern)
+{
+    std::vector<std::string> labels;
+    for (int pattern = 1; pattern <= constants::NUM_PATTERNS; ++pattern) {
+        labels.push_back(std::to_string(pattern));
+    }
+    return rack::createIndexSubmenuItem("Pattern", labels, getPattern, setPattern);
+}
@@ -1,10 +1,14 @@
 
 #include <array>
+#include "Bus.hpp"
 #include "GaitX.hpp"
+#include "HistX.hpp"
 #include "InX.hpp"
+#include "MathX.hpp"
 #include "ModX.hpp"
 #include "OutX.hpp"
 #include "ReX.hpp"
+#include "SortX.hpp"
 #include "biexpander/biexpander.hpp"
 #include "comp/ports.hpp"
 #include "constants.hpp"
@@ -31,6 +35,9 @@ class Phi : public biexpand::Expandable<float> {
     InxAdapter inx;
     ModXAdapter modx;
     GaitXAdapter gaitx;
+    SortxAdapter sortx;
+    MathxAdapter mathx;
+    HistxAdapter histx;
 
     /// @brief: is the current step modified?
     /// XXX this should be an array so that each channels have its modParams, or see if we can use
@@ -40,11 +47,24 @@ class Phi : public biexpand::Expandable<float> {
 
     bool usePhasor = false;
     bool allowReverseTrigger = false;
+    /// @brief Each channel of the driver gets its own pass through the expander chain
+    bool polyChain = false;
+    /// @brief Poly chain values for Out<sup>x</sup>, transposed to [port][channel]
+    alignas(16) std::array<float, MAX_STEPS * NUM_CHANNELS> outxValues{};
+    /// @brief Bit c of outxChannels[port] is set when channel c has a step for port
+    std::array<uint16_t, MAX_STEPS> outxChannels{};
+    int polyChainChannels = 0;
+    /// @brief Without Out<sup>x</sup> the steps are resolved one at a time through the chain
+    /// @details lazyValues caches the steps resolved since the last change of the chain.
+    bool lazySteps = false;
+    int lazyStepCount = 0;
+    uint16_t lazyResolved = 0;
+    std::array<float, MAX_STEPS> lazyValues{};
     float gateLength = 1e-3F;
 
     dsp::SchmittTrigger resetTrigger;
-    dsp::SchmittTrigger nextTrigger;
-    dsp::SchmittTrigger prevTrigger;
+    std::array<dsp::SchmittTrigger, NUM_CHANNELS> nextTrigger;
+    std::array<dsp::SchmittTrigger, NUM_CHANNELS> prevTrigger;
     dsp::PulseGenerator resetPulse;  // ignore clock for 1ms after reset
 
     std::array<sp::HCVPhasorStepDetector, MAX_GATES> stepDetectors;
@@ -69,11 +89,18 @@ class Phi : public biexpand::Expandable<float> {
     std::array<float, NUM_CHANNELS> lastCvOut = {};
 
     dsp::ClockDivider uiDivider;
+    /// @brief Replaces the poly input when a bus is selected
+    bus::Receiver busIn;
 
     bool readVoltages(bool forced = false)
     {
-        const bool changed = this->cacheState.needsRefreshing();
-        if (changed || forced) {
+        const bool news = busIn.hasNews();
+        const bool changed = this->cacheState.needsRefreshing() || news;
+        if (busIn && (changed || forced)) {
+            busIn.read(readBuffer());
+            cacheState.refresh();
+        }
+        else if (changed || forced) {
             auto& input = inputs[INPUT_CV];
             auto channels = input.isConnected() ? input.getChannels() : 0;
             readBuffer().resize(channels);
@@ -86,6 +113,23 @@ class Phi : public biexpand::Expandable<float> {
         return changed;
     }
 
+    /// @brief Number of steps in the (transformed) buffer the play head of channel reads from
+    int stepCount(int channel)
+    {
+        if (polyChain) { return polyBufferSize(channel); }
+        return lazySteps ? lazyStepCount : static_cast<int>(readBuffer().size());
+    }
+    float stepValue(int channel, int index)
+    {
+        if (polyChain) { return polyBufferValue(channel, index); }
+        if (!lazySteps) { return readBuffer()[index]; }
+        if (!(lazyResolved & (1U << index))) {
+            lazyValues[index] = queryChain(index, 0);
+            lazyResolved |= 1U << index;
+        }
+        return lazyValues[index];
+    }
+
     void writeVoltages()
     {
         const auto channels =
@@ -102,8 +146,14 @@ class Phi : public biexpand::Expandable<float> {
 
    public:
     Phi()
-        : biexpand::Expandable<float>({{modelReX, &rex}, {modelInX, &inx}, {modelModX, &modx}},
-                                      {/*{modelOutX, &outx},*/ {modelGaitX, &gaitx}})
+        : biexpand::Expandable<float>(
+              {{modelReX, &rex},
+               {modelInX, &inx},
+               {modelModX, &modx},
+               {modelSortX, &sortx},
+               {modelMathX, &mathx},
+               {modelHistX, &histx}},
+              {{modelOutX, &outx}, {modelGaitX, &gaitx}})
     {
         config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
 
@@ -132,14 +182,13 @@ class Phi : public biexpand::Expandable<float> {
     }
     void updateProgressLights(int numChannels)
     {
-        if (readBuffer().empty()) { return; }
         for (int lightIdx = 0; lightIdx < MAX_STEPS; ++lightIdx) {
             bool lightOn = false;
             for (int chan = 0; chan < numChannels; ++chan) {
+                const int numSteps = stepCount(chan);
+                if (numSteps == 0) { continue; }
                 const int start = rex.getStart(chan);
-                if (((stepDetectors[chan].getCurrentStep()) %
-                         static_cast<int>(readBuffer().size()) +
-                     start) %
+                if (((stepDetectors[chan].getCurrentStep()) % numSteps + start) %
                         MAX_STEPS ==
                     lightIdx) {
                     lightOn = true;
@@ -196,12 +245,12 @@ class Phi : public biexpand::Expandable<float> {
             outputs[OUTPUT_TRIGGER].setVoltage(10.F * (high || gateTrigger), channel);
         }
     }
-    void updateModParams(int curStep)
+    void updateModParams(int channel, int curStep)
     {
         if (modx) { modParams = modx.getParams(curStep); }
         if (modParams.prob < 1.0F) {
             if (random::uniform() > modParams.prob) {
-                randomizedSteps[curStep] = random::u32() % readBuffer().size();
+                randomizedSteps[curStep] = random::u32() % stepCount(channel);
             }
         }
         else {
@@ -227,13 +276,14 @@ class Phi : public biexpand::Expandable<float> {
                              : false;
         const bool isNextConnected = inputs[INPUT_NEXT].isConnected();
         const bool isNextNormalled = isClockConnected && !isNextConnected;
-        const int numSteps = readBuffer().size();
+        const int numSteps = stepCount(channel);
         // update our next trigger normalled to the clock if not connected
         const float nextCv = inputs[INPUT_NEXT].getNormalPolyVoltage(0.F, channel);
         const bool isNextTriggered =
-            isNextConnected ? nextTrigger.process(nextCv) : isClockTriggered;
-        const bool isPrevTriggered =
-            isNextConnected && allowReverseTrigger ? prevTrigger.process(-nextCv) : false;
+            isNextConnected ? nextTrigger[channel].process(nextCv) : isClockTriggered;
+        const bool isPrevTriggered = isNextConnected && allowReverseTrigger
+                                         ? prevTrigger[channel].process(-nextCv)
+                                         : false;
         const bool isTriggered = isNextTriggered || isPrevTriggered;
         if (isTriggered) {
             float period =
@@ -260,8 +310,11 @@ class Phi : public biexpand::Expandable<float> {
     {
         const bool cvOutConnected = outputs[OUTPUT_CV].isConnected();
 
-        const int numSteps = readBuffer().size();
-        if (numSteps == 0) {
+        bool hasSteps = false;
+        for (int channel = 0; channel < std::max(channels, 1); ++channel) {
+            hasSteps |= stepCount(channel) > 0;
+        }
+        if (!hasSteps) {
             writeBuffer().resize(0);
             return;
         }
@@ -269,6 +322,13 @@ class Phi : public biexpand::Expandable<float> {
             writeBuffer().resize(channels);  // XXX Isn't this done by the baseadapter class?
         }  // XXX I doubt this to be complete when we'll be using channels
         for (int channel = 0; channel < channels; ++channel) {
+            const int numSteps = stepCount(channel);
+            if (numSteps == 0) {
+                // Only in poly chain mode: the chain of this channel left no steps
+                writeBuffer()[channel] = 0.F;
+                lastCvOut[channel] = 0.F;
+                continue;
+            }
             float curCv = inputs[INPUT_DRIVER].getNormalPolyVoltage(0.F, channel);
 
             stepDetectors[channel].setNumberSteps(numSteps);
@@ -284,20 +344,20 @@ class Phi : public biexpand::Expandable<float> {
             const float fractionalIndex = stepDetectors[channel].getFractionalStep();
             bool reversePhasor = slopeDetectors[channel](normalizedPhasor) < 0.0f;
             // Are we on a new step?
-            if (newStep) { updateModParams(curStep); }
+            if (newStep) { updateModParams(channel, curStep); }
             if (cvOutConnected || outx) {
                 // Can the buffer size change? after updateModParams?
                 // If it can, we'll crash here, or because of here.
-                if (randomizedSteps[curStep] >= static_cast<int>(readBuffer().size())) {
+                if (randomizedSteps[curStep] >= numSteps) {
                     // And apparently it can.
                     // XXX We update here quick and dirty instead of updateModParams to not crash
                     // when smart is enabled in VCV
-                    randomizedSteps[curStep] = random::u32() % readBuffer().size();
+                    randomizedSteps[curStep] = random::u32() % numSteps;
                 }
-                assert(randomizedSteps[curStep] < static_cast<int>(readBuffer().size()));  // NOLINT
+                assert(randomizedSteps[curStep] < numSteps);  // NOLINT
                 // Route through the random steps if prob < 1.0
-                float cv = modParams.prob < 1.0F ? readBuffer().at(randomizedSteps[curStep])
-                                                 : readBuffer().at(curStep);
+                float cv = modParams.prob < 1.0F ? stepValue(channel, randomizedSteps[curStep])
+                                                 : stepValue(channel, curStep);
                 if (modParams.glide) {
                     if (newStep) {
                         // Initiate the glide
@@ -328,7 +388,8 @@ class Phi : public biexpand::Expandable<float> {
             resetPulse.trigger(1e-3F);  // ignore clock for 1ms after reset
             for (int i = 0; i < NUM_CHANNELS; ++i) {
                 clockTracker[i].init(keepPeriod ? clockTracker[i].getPeriod() : 0.1F);
-                nextTrigger.reset();
+                nextTrigger[i].reset();
+                prevTrigger[i].reset();
                 stepDetectors[i].setStep(0);
                 nextTimer[i].reset();
             }
@@ -344,24 +405,51 @@ class Phi : public biexpand::Expandable<float> {
         // Update our buffer because an adapter is dirty and our buffer needs to be updated
         if (!changed && !forced && dirtyAdapters) { readVoltages(true); }
 
-        if (changed || dirtyAdapters || forced) {
-            for (biexpand::Adapter* adapter : getLeftAdapters()) {
-                transform(*adapter);
-            }
+        const int channels = std::max(inputs[INPUT_DRIVER].getChannels(), 1);
+        if (changed || dirtyAdapters || forced) { lazySteps = false; }
+        if (polyChain && (changed || dirtyAdapters || forced || channels != polyChainChannels)) {
+            // Only the channels whose expander inputs changed need a new pass through the chain
+            constexpr uint16_t allChannels = 0xFFFF;
+            const uint16_t channelMask =
+                (changed || forced) ? allChannels : dirtyAdapterChannels();
+            transformPolyChain(channelMask, [this](int channel, auto first, int length) {
+                const uint16_t bit = 1U << channel;
+                for (int port = 0; port < MAX_STEPS; ++port) {
+                    const bool hasStep = port < length;
+                    outxValues[port * NUM_CHANNELS + channel] = hasStep ? *(first + port) : 0.F;
+                    outxChannels[port] = hasStep ? (outxChannels[port] | bit)
+                                                 : (outxChannels[port] & ~bit);
+                }
+            });
+            polyChainChannels = channels;
+            if (outx) { outx.writePoly(outxValues.data(), outxChannels, channels); }
+            writeVoltages();
+        }
+        else if ((changed || dirtyAdapters || forced) && !outx && canQueryChain()) {
+            // Only the steps the play head reaches get resolved, see stepValue()
+            lazySteps = true;
+            lazyStepCount = queryChainLength(0);
+            lazyResolved = 0;
+            refreshLeftAdapters();
+            writeVoltages();
+        }
+        else if (changed || dirtyAdapters || forced) {
+            transformLeftAdapters();
             if (outx) { outx.write(readBuffer().begin(), readBuffer().end()); }
-            transform(outx);
+            transformRightAdapters();
             writeVoltages();
         }
     }
     void process(const ProcessArgs& args) override
     {
+        resolvePendingChain();
         const bool driverConnected = inputs[INPUT_DRIVER].isConnected();
-        const bool cvInConnected = inputs[INPUT_CV].isConnected();
+        const bool cvInConnected = inputs[INPUT_CV].isConnected() || busIn.getSelected() >= 0;
         const bool cvOutConnected = outputs[OUTPUT_CV].isConnected();
         const bool trigOutConnected = outputs[OUTPUT_TRIGGER].isConnected();
         if (!driverConnected && !cvInConnected && !cvOutConnected) { return; }
-        // XXX Here disable polyphony for the input clock for now
-        const auto inputChannels = 1;
+        // Without poly chain, polyphony for the input clock is disabled for now
+        const auto inputChannels = polyChain ? std::max(inputs[INPUT_DRIVER].getChannels(), 1) : 1;
         performTransforms();
 
         if (!usePhasor) { checkReset(); }
@@ -374,8 +462,6 @@ class Phi : public biexpand::Expandable<float> {
         writeVoltages();
 
         if (gaitx && gaitx->cacheState.isDirty()) { gaitx->cacheState.refresh(); }
-        // if (outx && outx->cacheState.isDirty()) { outx->cacheState.refresh(); } // we're not outx
-        // compatible
     }
 
     json_t* dataToJson() override
@@ -386,6 +472,8 @@ class Phi : public biexpand::Expandable<float> {
         json_object_set_new(rootJ, "keepPeriod", json_boolean(keepPeriod));
         json_object_set_new(rootJ, "allowReverseTrigger", json_boolean(allowReverseTrigger));
         json_object_set_new(rootJ, "gateLength", json_real(gateLength));
+        json_object_set_new(rootJ, "polyChain", json_boolean(polyChain));
+        json_object_set_new(rootJ, "receiveBus", json_integer(busIn.getSelected()));
         return rootJ;
     }
 
@@ -401,6 +489,11 @@ class Phi : public biexpand::Expandable<float> {
         if (allowReverseTriggerJ) { allowReverseTrigger = json_is_true(allowReverseTriggerJ); }
         json_t* gateLengthJ = json_object_get(rootJ, "gateLength");
         if (gateLengthJ) { gateLength = json_real_value(gateLengthJ); }
+        json_t* polyChainJ = json_object_get(rootJ, "polyChain");
+        if (polyChainJ) { polyChain = json_is_true(polyChainJ); }
+        json_t* receiveBusJ = json_object_get(rootJ, "receiveBus");
+        if (receiveBusJ) { busIn.select(json_integer_value(receiveBusJ)); }
+        cacheState.setParamDirty();
     }
 
    private:
@@ -484,6 +577,16 @@ struct PhiWidget : public SIMWidget {
                                              &module->allowReverseTrigger));
         menu->addChild(
             createBoolPtrMenuItem("Remember speed after reset", "", &module->keepPeriod));
+        menu->addChild(createBoolMenuItem(
+            "Poly chain", "", [module]() { return module->polyChain; },
+            [module](bool polyChain) {
+                module->polyChain = polyChain;
+                // Force a pass through the chain in the newly selected mode
+                module->cacheState.setParamDirty();
+            }));
+        menu->addChild(bus::createMenuItem(
+            "Receive from bus", [module]() { return module->busIn.getSelected(); },
+            [module](int index) { module->busIn.select(index); }));
 
         auto* gateLengthSlider = new GateLengthSlider(&(module->gateLength), 1e-3F, 1.F);
         gateLengthSlider->box.size.x = 200.0f;
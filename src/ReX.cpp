@@ -8,8 +8,9 @@ ReX::ReX() : biexpand::BiExpander(false)
 {
     config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
 
-    configParam(PARAM_START, 0.0F, 15.0F, 0.0F, "Start", "", 0.0F, 1.0F, 1.0F);
-    configParam(PARAM_LENGTH, 1.0F, 16.0F, 16.0F, "Length");
+    configParam<biexpand::CachedParamQuantity<>>(PARAM_START, 0.0F, 15.0F, 0.0F, "Start", "",
+                                                 0.0F, 1.0F, 1.0F);
+    configParam<biexpand::CachedParamQuantity<>>(PARAM_LENGTH, 1.0F, 16.0F, 16.0F, "Length");
 
     getParamQuantity(PARAM_START)->snapEnabled = true;
     getParamQuantity(PARAM_LENGTH)->snapEnabled = true;
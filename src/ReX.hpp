@@ -1,4 +1,7 @@
 #pragma once
+#include <array>
+#include <cstdint>
+#include <iterator>
 #include <rack.hpp>
 #include "biexpander/biexpander.hpp"
 #include "constants.hpp"
@@ -15,6 +18,25 @@ struct ReX : public biexpand::BiExpander {
     ReX();
 };
 
+namespace rex {
+/// @brief Gather indices for every (input size, start) pair.
+/// @details gatherTable[size][start][i] is the input index of output element i when an input of
+/// `size` elements is read from `start` onwards, wrapping around. Built at compile time so a ReX
+/// transform is a single table-driven gather regardless of start and length.
+using GatherIndices = std::array<uint8_t, constants::MAX_GATES>;
+inline constexpr auto gatherTable = []() {
+    std::array<std::array<GatherIndices, constants::MAX_GATES>, constants::MAX_GATES + 1> table{};
+    for (int size = 1; size <= constants::MAX_GATES; ++size) {
+        for (int start = 0; start < constants::MAX_GATES; ++start) {
+            for (int i = 0; i < constants::MAX_GATES; ++i) {
+                table[size][start][i] = static_cast<uint8_t>((start + i) % size);
+            }
+        }
+    }
+    return table;
+}();
+}  // namespace rex
+
 class RexAdapter : public biexpand::BaseAdapter<ReX> {
    public:
     using FloatIter = iters::FloatIter;
@@ -25,57 +47,73 @@ class RexAdapter : public biexpand::BaseAdapter<ReX> {
     Iter transformImpl(Iter first, Iter last, Iter out, int channel = 0) const
     {
         if (first == last) { return out; }
-        const auto start = getStart(channel);
-        const auto length = getLength(channel);
-        const auto outputStart = out;
-        const auto inputSize = last - first;
-
-        if (first + start + length <= last) {
-            // If no wrap-around is needed, just perform a single copy operation
-            return std::copy(first + start, first + start + length, out);
+        const int inputSize = static_cast<int>(last - first);
+        const int length = getLength(channel);
+        int start = getStart(channel);
+        // A start beyond the end of the input restarts at the beginning of the input
+        if (start >= inputSize) { start = 0; }
+        const rex::GatherIndices& indices = rex::gatherTable[inputSize][start];
+        for (int i = 0; i < length; ++i, ++out) {
+            *out = first[indices[i]];
         }
+        return out;
+    }
 
-        // Do we start before the end of the input?
-        if (first + start < last) { out = std::copy(first + start, last, out); }
-
-        // And repeat copying full inputs
-        while (out - outputStart + inputSize < length) {
-            out = std::copy(first, last, out);
+    template <typename Iter>
+    void transformInPlaceImpl(Iter first, Iter last, int channel) const
+    {
+        const int totalElements = static_cast<int>(last - first);
+        if (totalElements == 0) { return; }
+        const int start = getStart(channel) % totalElements;
+        const rex::GatherIndices& indices = rex::gatherTable[totalElements][start];
+        std::array<typename std::iterator_traits<Iter>::value_type, constants::MAX_GATES> source{};
+        std::copy(first, last, source.begin());
+        for (int i = 0; i < totalElements; ++i) {
+            first[i] = source[indices[i]];
         }
-        // And finally, copy the remainder
-        return std::copy_n(first, length - (out - outputStart), out);
     }
 
-    mutable std::vector<Param> prevParams;
-    mutable std::vector<Input> prevInputs;
-
    public:
     bool inPlace(int length, int channel) const override
     {
         return getLength(channel) == length;
     }
+    bool canQuery() const override
+    {
+        return true;
+    }
+    int queryLength(int inputLength, int channel) const override
+    {
+        return inputLength == 0 ? 0 : getLength(channel);
+    }
+    /// @brief Same start handling as the in place and copying transforms
+    int querySource(int index, int inputLength, int channel) const override
+    {
+        int start = getStart(channel);
+        if (inPlace(inputLength, channel)) { start %= inputLength; }
+        else if (start >= inputLength) {
+            start = 0;
+        }
+        return rex::gatherTable[inputLength][start][index];
+    }
+    /// @brief A new start or length moves every element
+    uint16_t mapDirty(uint16_t dirty, int inputLength, int channel) const override
+    {
+        if (ptr->cacheState.getChangedParams() || ptr->cacheState.getChangedInputs()) {
+            return ALL_INDICES;
+        }
+        return mapDirtyBySource(dirty, inputLength, channel);
+    }
     ///@ Transform (in place)
     void transformInPlace(FloatIter first, FloatIter last, int channel) const override
     {
-        const auto totalElements = std::distance(first, last);
-        const auto startOffset = getStart(channel) % totalElements;
-
-        auto newStartIterator = first;
-        std::advance(newStartIterator, startOffset);
-
-        std::rotate(first, newStartIterator, last);
+        transformInPlaceImpl(first, last, channel);
     };
 
     ///@ Transform (in place)
-    void transformInPlace(BoolIter first, BoolIter last, int channel) const override  // XXX DOUBLE
+    void transformInPlace(BoolIter first, BoolIter last, int channel) const override
     {
-        const auto totalElements = std::distance(first, last);
-        const auto startOffset = getStart(channel) % totalElements;
-
-        auto newStartIterator = first;
-        std::advance(newStartIterator, startOffset);
-
-        std::rotate(first, newStartIterator, last);
+        transformInPlaceImpl(first, last, channel);
     };
     BoolIter transform(BoolIter first, BoolIter last, BoolIter out, int channel) const override
     {
@@ -104,9 +142,10 @@ class RexAdapter : public biexpand::BaseAdapter<ReX> {
             return clamp(static_cast<int>(ptr->params[ReX::PARAM_LENGTH].getValue()), 1, max);
         }
 
-        return clamp(static_cast<int>(rescale(ptr->inputs[ReX::INPUT_LENGTH].getVoltage(channel), 0,
-                                              10, 1, static_cast<float>(max + 1))),
-                     1, max);
+        return clamp(
+            static_cast<int>(rescale(ptr->inputs[ReX::INPUT_LENGTH].getPolyVoltage(channel), 0, 10,
+                                     1, static_cast<float>(max + 1))),
+            1, max);
     };
     int getStart(int channel = 0, int max = constants::MAX_GATES) const
     {
@@ -1,4 +1,5 @@
 #include "Shared.hpp"
+#include <array>
 #include <cmath>
 #include <cstdlib>
 #include <map>
@@ -59,6 +60,15 @@ float getVoctFromNote(const std::string& noteName, float onErrorVal)
     }
     return noteVoltage + octave - 4;  // -4 because 0V is C4
 }
+/// @brief The voltage of a MIDI note number, as getVoctFromNote() (note 60 is C4, 0V)
+float getVoctFromMidiNote(int note)
+{
+    static const std::array<const char*, 12> noteNames = {"C",  "C#", "D",  "D#", "E",  "F",
+                                                          "F#", "G",  "G#", "A",  "A#", "B"};
+    const int octave = note / 12 - 1;
+    // Same arithmetic as getVoctFromNote(), so both give the very same voltages
+    return noteToVoltage.at(noteNames[note % 12]) + octave - 4;
+}
 /// @brief Get a string representation of a float value as a fraction
 std::string getFractionalString(float value, int numerator, int denominator)
 {
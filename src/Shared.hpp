@@ -4,6 +4,7 @@
 
 std::string getFractionalString(float value, int numerator, int denominator);
 float getVoctFromNote(const std::string& noteName, float onErrorVal);
+float getVoctFromMidiNote(int note);
 std::string getNoteFromVoct(int rootNote, bool majorScale, int noteNumber);
 
 /**
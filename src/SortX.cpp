@@ -0,0 +1,64 @@
+#include "SortX.hpp"
+#include "comp/knobs.hpp"
+#include "comp/ports.hpp"
+#include "constants.hpp"
+#include "plugin.hpp"
+
+SortX::SortX() : biexpand::BiExpander(false)
+{
+    config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+
+    configSwitch<biexpand::CachedParamQuantity<SwitchQuantity>>(
+        PARAM_MODE, 0.0F, static_cast<float>(static_cast<int>(Mode::MODES_LEN) - 1), 0.0F, "Mode",
+        {"Sort ascending", "Sort descending", "Reverse", "Interleave", "Shuffle"});
+    configParam<biexpand::CachedParamQuantity<>>(PARAM_SEED, 0.0F, sortx::NUM_SEEDS - 1.0F, 0.0F,
+                                                 "Shuffle seed");
+    getParamQuantity(PARAM_SEED)->snapEnabled = true;
+    configInput(INPUT_MODE, "Mode CV");
+    configInput(INPUT_SEED, "Shuffle seed CV");
+    configCache();
+};
+
+using namespace dimensions;  // NOLINT
+struct SortXWidget : public SIMWidget {
+    explicit SortXWidget(SortX* module)
+    {
+        const float center = 1.F * HP;
+        setModule(module);
+        setSIMPanel("SortX");
+
+        if (module) {
+            module->connectionLights.addDefaultConnectionLights(this, -1,
+                                                                SortX::LIGHT_RIGHT_CONNECTED);
+        }
+
+        addParam(createParamCentered<comp::SIMKnob>(
+            mm2px(Vec(center, JACKYSTART + 0 * PARAMJACKNTXT)), module, SortX::PARAM_MODE));
+        addInput(createInputCentered<comp::SIMPort>(
+            mm2px(Vec(center, JACKYSTART + 0 * PARAMJACKNTXT + JACKYSPACE)), module,
+            SortX::INPUT_MODE));
+
+        addParam(createParamCentered<comp::SIMKnob>(
+            mm2px(Vec(center, JACKYSTART + 1 * PARAMJACKNTXT)), module, SortX::PARAM_SEED));
+        addInput(createInputCentered<comp::SIMPort>(
+            mm2px(Vec(center, JACKYSTART + 1 * PARAMJACKNTXT + JACKYSPACE)), module,
+            SortX::INPUT_SEED));
+    }
+
+    void appendContextMenu(Menu* menu) override
+    {
+        auto* module = dynamic_cast<SortX*>(this->module);
+        assert(module);  // NOLINT
+
+        menu->addChild(createIndexSubmenuItem(
+            "Mode", {"Sort ascending", "Sort descending", "Reverse", "Interleave", "Shuffle"},
+            [module]() {
+                return static_cast<size_t>(module->params[SortX::PARAM_MODE].getValue());
+            },
+            [module](size_t mode) {
+                module->params[SortX::PARAM_MODE].setValue(static_cast<float>(mode));
+            }));
+        SIMWidget::appendContextMenu(menu);
+    }
+};
+Model* modelSortX = createModel<SortX, SortXWidget>("SortX");  // NOLINT
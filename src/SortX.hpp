@@ -0,0 +1,208 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <rack.hpp>
+#include "biexpander/biexpander.hpp"
+#include "constants.hpp"
+#include "helpers/iters.hpp"
+
+using namespace rack;  // NOLINT
+
+struct SortX : public biexpand::BiExpander {
+    enum ParamId { PARAM_MODE, PARAM_SEED, PARAMS_LEN };
+    enum InputId { INPUT_MODE, INPUT_SEED, INPUTS_LEN };
+    enum OutputId { OUTPUTS_LEN };
+    enum LightId { LIGHT_RIGHT_CONNECTED, LIGHTS_LEN };
+    enum class Mode { SORT_UP, SORT_DOWN, REVERSE, INTERLEAVE, SHUFFLE, MODES_LEN };
+    SortX();
+};
+
+namespace sortx {
+constexpr int NUM_SEEDS = 16;
+using Indices = std::array<uint8_t, constants::MAX_STEPS>;
+/// @brief Index tables for every input size: table[size][i] is the input index of output i
+using IndexTable = std::array<Indices, constants::MAX_STEPS + 1>;
+
+/// @brief Compare-exchange pairs of Batcher's odd-even merge sort for 16 elements
+/// @details 63 pairs in 10 layers. The order of the pairs doesn't depend on the data, so a sort
+/// is a fixed sequence of min/max operations without branches.
+struct Comparator {
+    uint8_t low;
+    uint8_t high;
+};
+inline constexpr auto sortingNetwork = []() {
+    constexpr int size = constants::MAX_STEPS;
+    std::array<Comparator, 63> network{};
+    int count = 0;
+    for (int p = 1; p < size; p *= 2) {
+        for (int k = p; k >= 1; k /= 2) {
+            for (int j = k % p; j + k < size; j += 2 * k) {
+                for (int i = 0; i < std::min(k, size - j - k); ++i) {
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p)) {
+                        network[count++] = {static_cast<uint8_t>(i + j),
+                                            static_cast<uint8_t>(i + j + k)};
+                    }
+                }
+            }
+        }
+    }
+    return network;
+}();
+
+/// @brief Sorts the first length values, the rest of the network is padded so it stays in place
+template <bool ASCENDING>
+inline void sort(std::array<float, constants::MAX_STEPS>& values, int length)
+{
+    constexpr float padding = ASCENDING ? std::numeric_limits<float>::infinity()
+                                        : -std::numeric_limits<float>::infinity();
+    std::fill(values.begin() + length, values.end(), padding);
+    for (const Comparator& comparator : sortingNetwork) {
+        const float low = values[comparator.low];
+        const float high = values[comparator.high];
+        values[comparator.low] = ASCENDING ? std::min(low, high) : std::max(low, high);
+        values[comparator.high] = ASCENDING ? std::max(low, high) : std::min(low, high);
+    }
+}
+
+inline constexpr IndexTable reverseTable = []() {
+    IndexTable table{};
+    for (int size = 1; size <= constants::MAX_STEPS; ++size) {
+        for (int i = 0; i < size; ++i) {
+            table[size][i] = static_cast<uint8_t>(size - 1 - i);
+        }
+    }
+    return table;
+}();
+/// @brief Even outputs from the first half, odd outputs from the second half
+inline constexpr IndexTable interleaveTable = []() {
+    IndexTable table{};
+    for (int size = 1; size <= constants::MAX_STEPS; ++size) {
+        const int half = (size + 1) / 2;
+        for (int i = 0; i < size; ++i) {
+            table[size][i] = static_cast<uint8_t>(i % 2 == 0 ? i / 2 : half + i / 2);
+        }
+    }
+    return table;
+}();
+/// @brief Fisher-Yates shuffles by seed and size, the same seed always gives the same order
+inline constexpr auto shuffleTable = []() {
+    std::array<IndexTable, NUM_SEEDS> tables{};
+    for (int seed = 0; seed < NUM_SEEDS; ++seed) {
+        uint32_t state = 0x9E3779B9U * static_cast<uint32_t>(seed + 1);
+        for (int size = 1; size <= constants::MAX_STEPS; ++size) {
+            Indices& indices = tables[seed][size];
+            for (int i = 0; i < size; ++i) {
+                indices[i] = static_cast<uint8_t>(i);
+            }
+            for (int i = size - 1; i > 0; --i) {
+                // xorshift32
+                state ^= state << 13U;
+                state ^= state >> 17U;
+                state ^= state << 5U;
+                std::swap(indices[i], indices[state % static_cast<uint32_t>(i + 1)]);
+            }
+        }
+    }
+    return tables;
+}();
+}  // namespace sortx
+
+/// @brief Sorts or permutes the buffer
+/// @details Sorting runs a fixed sorting network. The permutations are table lookups and answer
+/// point queries, so reverse, interleave and shuffle are fused with the rest of the chain.
+class SortxAdapter : public biexpand::BaseAdapter<SortX> {
+   public:
+    using FloatIter = iters::FloatIter;
+    using BoolIter = iters::BoolIter;
+
+   private:
+    int getStep(int paramId, int inputId, int channel, int max) const
+    {
+        if (!ptr->inputs[inputId].isConnected()) {
+            return clamp(static_cast<int>(ptr->params[paramId].getValue()), 0, max);
+        }
+        return clamp(static_cast<int>(rescale(ptr->inputs[inputId].getPolyVoltage(channel), 0, 10,
+                                              0.F, static_cast<float>(max + 1))),
+                     0, max);
+    }
+    SortX::Mode getMode(int channel) const
+    {
+        constexpr int lastMode = static_cast<int>(SortX::Mode::MODES_LEN) - 1;
+        return static_cast<SortX::Mode>(
+            getStep(SortX::PARAM_MODE, SortX::INPUT_MODE, channel, lastMode));
+    }
+    static bool isPermutation(SortX::Mode mode)
+    {
+        return mode != SortX::Mode::SORT_UP && mode != SortX::Mode::SORT_DOWN;
+    }
+    /// @brief The index table of a permutation mode
+    const sortx::Indices& getIndices(SortX::Mode mode, int size, int channel) const
+    {
+        switch (mode) {
+            case SortX::Mode::INTERLEAVE: return sortx::interleaveTable[size];
+            case SortX::Mode::SHUFFLE:
+                return sortx::shuffleTable[getStep(SortX::PARAM_SEED, SortX::INPUT_SEED, channel,
+                                                   sortx::NUM_SEEDS - 1)][size];
+            default: return sortx::reverseTable[size];
+        }
+    }
+
+   public:
+    bool inPlace(int /*length*/, int /*channel*/) const override
+    {
+        return true;
+    }
+    /// @brief Only permutations answer queries, a sorted element depends on all the others
+    bool canQuery() const override
+    {
+        return !ptr->inputs[SortX::INPUT_MODE].isConnected() && isPermutation(getMode(0));
+    }
+    int querySource(int index, int inputLength, int channel) const override
+    {
+        return getIndices(getMode(channel), inputLength, channel)[index];
+    }
+    bool reordersIndices(int inputLength, int /*channel*/) const override
+    {
+        return inputLength > 1;
+    }
+    uint16_t mapDirty(uint16_t dirty, int inputLength, int channel) const override
+    {
+        if (ptr->cacheState.getChangedParams() || ptr->cacheState.getChangedInputs()) {
+            return ALL_INDICES;
+        }
+        return mapDirtyBySource(dirty, inputLength, channel);
+    }
+    void transformInPlace(FloatIter first, FloatIter last, int channel) const override
+    {
+        const int length = static_cast<int>(last - first);
+        if (length == 0) { return; }
+        std::array<float, constants::MAX_STEPS> values{};
+        std::copy(first, last, values.begin());
+        const SortX::Mode mode = getMode(channel);
+        if (isPermutation(mode)) {
+            const sortx::Indices& indices = getIndices(mode, length, channel);
+            for (int i = 0; i < length; ++i) {
+                first[i] = values[indices[i]];
+            }
+            return;
+        }
+        if (mode == SortX::Mode::SORT_UP) {
+            sortx::sort<true>(values, length);
+        }
+        else {
+            sortx::sort<false>(values, length);
+        }
+        std::copy(values.begin(), values.begin() + length, first);
+    }
+    FloatIter transform(FloatIter first,
+                        FloatIter last,
+                        FloatIter out,
+                        int channel) const override
+    {
+        FloatIter end = std::copy(first, last, out);
+        transformInPlace(out, end, channel);
+        return end;
+    }
+};
@@ -6,8 +6,12 @@
 #include <cassert>
 #include <cmath>
 #include <vector>
+#include "BeatX.hpp"
 #include "GaitX.hpp"
+#include "HistX.hpp"
 #include "InX.hpp"
+#include "LogX.hpp"
+#include "MidiImport.hpp"
 #include "ModX.hpp"
 #include "OutX.hpp"
 #include "ReX.hpp"
@@ -46,7 +50,7 @@ struct Spike : public biexpand::Expandable<bool> {
 
    private:
     friend struct SpikeWidget;
-    struct SpikeParamQuantity : ParamQuantity {
+    struct SpikeParamQuantity : biexpand::CachedParamQuantity<> {
         std::string getString() override
         {
             return ParamQuantity::getValue() > constants::BOOL_TRESHOLD ? "On" : "Off";
@@ -65,6 +69,9 @@ struct Spike : public biexpand::Expandable<bool> {
     InxAdapter inx;
     ModXAdapter modx;
     GaitXAdapter gaitx;
+    BeatxAdapter beatx;
+    LogxAdapter logx;
+    HistxAdapter histx;
 
     std::array<sp::HCVPhasorStepDetector, MAX_GATES> stepDetectors;
 #ifndef NOPHASOR
@@ -95,6 +102,7 @@ struct Spike : public biexpand::Expandable<bool> {
 
     std::array<bool, MAX_GATES> bitMemory = {};
     std::array<bool, MAX_GATES> randomizedMemory = {};
+    midiimport::Importer importer;
 
     /// @brief: returns the normalized relative gate duration of step
     float getDuration(int step) const
@@ -115,10 +123,27 @@ struct Spike : public biexpand::Expandable<bool> {
         bitMemory[gateIndex] = value;
     };
 
+    /// @brief Sets the gate switches to the first pattern of a finished MIDI import
+    void importGates()
+    {
+        const midiimport::Table* table = importer.acquire();
+        if (!table) { return; }
+        for (int i = 0; i < MAX_GATES; i++) {
+            params[PARAM_GATE + i].setValue(table->gatePattern(0)[i] ? 1.F : 0.F);
+        }
+        importer.release(table);
+        cacheState.setParamDirty();
+    }
+
    public:
     Spike()
         : Expandable<bool>(
-              {{modelReX, &this->rex}, {modelInX, &this->inx}, {modelModX, &this->modx}},
+              {{modelReX, &this->rex},
+               {modelInX, &this->inx},
+               {modelModX, &this->modx},
+               {modelBeatX, &this->beatx},
+               {modelLogX, &this->logx},
+               {modelHistX, &this->histx}},
               {{modelOutX, &this->outx}, {modelGaitX, &this->gaitx}})
     {
         config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
@@ -234,9 +259,7 @@ struct Spike : public biexpand::Expandable<bool> {
         if (!changed && !forced && dirtyAdapters) { readVoltages(true); }
 
         if (changed || dirtyAdapters || forced) {
-            for (biexpand::Adapter* adapter : getLeftAdapters()) {
-                transform(*adapter);
-            }
+            transformLeftAdapters();
         }
         return changed || dirtyAdapters || forced;
     }
@@ -303,6 +326,8 @@ struct Spike : public biexpand::Expandable<bool> {
     }
     void process(const ProcessArgs& args) override
     {
+        resolvePendingChain();
+        importGates();
         // const int numChannels = getPolyCount();
         // XXX Here disable polyphony for now
         const int numChannels = 1;
@@ -456,6 +481,11 @@ struct SpikeWidget : public SIMWidget {
     {
         ModuleWidget::draw(args);
     }
+    void step() override
+    {
+        if (auto* module = dynamic_cast<Spike*>(this->module)) { module->importer.poll(); }
+        SIMWidget::step();
+    }
 
     void appendContextMenu(Menu* menu) override
     {
@@ -465,6 +495,7 @@ struct SpikeWidget : public SIMWidget {
         menu->addChild(new MenuSeparator);
         menu->addChild(module->createExpandableSubmenu(this));
         menu->addChild(new MenuSeparator);
+        menu->addChild(midiimport::createImportMenuItem(module->importer));
 #ifndef NOPHASOR
         menu->addChild(createBoolPtrMenuItem("Use Phasor as input", "", &module->usePhasor));
         menu->addChild(createBoolPtrMenuItem("Connect Begin and End", "", &module->connectEnds));
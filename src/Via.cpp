@@ -1,6 +1,10 @@
+#include "Bus.hpp"
+#include "HistX.hpp"
 #include "InX.hpp"
+#include "MathX.hpp"
 #include "OutX.hpp"
 #include "ReX.hpp"
+#include "SortX.hpp"
 #include "biexpander/biexpander.hpp"
 #include "comp/ports.hpp"
 #include "constants.hpp"
@@ -19,12 +23,22 @@ struct Via : biexpand::Expandable<float> {
     friend struct ViaWidget;
     RexAdapter rex;
     InxAdapter inx;
+    SortxAdapter sortx;
+    MathxAdapter mathx;
+    HistxAdapter histx;
     OutxAdapter outx;
+    bus::Receiver busIn;
+    bus::Sender busOut;
 
     bool readVoltages(bool forced = false)
     {
-        const bool changed = this->cacheState.needsRefreshing();
-        if (changed || forced) {
+        const bool news = busIn.hasNews();
+        const bool changed = this->cacheState.needsRefreshing() || news;
+        if (busIn && (changed || forced)) {
+            busIn.read(readBuffer());
+            cacheState.refresh();
+        }
+        else if (changed || forced) {
             readBuffer().assign(inputs[INPUTS_IN].getVoltages(),
                                 inputs[INPUTS_IN].getVoltages() + inputs[INPUTS_IN].getChannels());
             cacheState.refresh();
@@ -41,7 +55,13 @@ struct Via : biexpand::Expandable<float> {
     }
 
    public:
-    Via() : Expandable({{modelReX, &this->rex}, {modelInX, &this->inx}}, {{modelOutX, &this->outx}})
+    Via()
+        : Expandable({{modelReX, &this->rex},
+                      {modelInX, &this->inx},
+                      {modelSortX, &this->sortx},
+                      {modelMathX, &this->mathx},
+                      {modelHistX, &this->histx}},
+                     {{modelOutX, &this->outx}})
     {
         config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
         configCache();
@@ -56,13 +76,27 @@ struct Via : biexpand::Expandable<float> {
         if (!changed && !forced && dirtyAdapters) { readVoltages(true); }
 
         if (changed || dirtyAdapters || forced) {
-            for (biexpand::Adapter* adapter : getLeftAdapters()) {
-                transform(*adapter);
-            }
+            transformLeftAdapters();
             if (outx) { outx.write(readBuffer().begin(), readBuffer().end()); }
-            transform(outx);
+            transformRightAdapters();
             writeVoltages();
         }
+        Output& output = outputs[OUTPUT_OUT];
+        busOut.publish(output.getVoltages(), output.getVoltages() + output.getChannels(),
+                       changed || dirtyAdapters || forced);
+    }
+
+    /// @brief Receiving the bus it sends on would feed a Via its own output, every sample anew
+    /// @details The side picked last wins, the other one is switched off.
+    void selectReceiveBus(int index)
+    {
+        if (index >= 0 && busOut.getSelected() == index) { busOut.select(-1); }
+        busIn.select(index);
+    }
+    void selectSendBus(int index)
+    {
+        if (index >= 0 && busIn.getSelected() == index) { busIn.select(-1); }
+        busOut.select(index);
     }
 
     void onUpdateExpanders(bool /*isRight*/) override
@@ -72,8 +106,25 @@ struct Via : biexpand::Expandable<float> {
 
     void process(const ProcessArgs& /*args*/) override
     {
+        resolvePendingChain();
         performTransforms();
     }
+
+    json_t* dataToJson() override
+    {
+        json_t* rootJ = json_object();
+        json_object_set_new(rootJ, "receiveBus", json_integer(busIn.getSelected()));
+        json_object_set_new(rootJ, "sendBus", json_integer(busOut.getSelected()));
+        return rootJ;
+    }
+
+    void dataFromJson(json_t* rootJ) override
+    {
+        json_t* receiveBusJ = json_object_get(rootJ, "receiveBus");
+        if (receiveBusJ) { selectReceiveBus(json_integer_value(receiveBusJ)); }
+        json_t* sendBusJ = json_object_get(rootJ, "sendBus");
+        if (sendBusJ) { selectSendBus(json_integer_value(sendBusJ)); }
+    }
 };
 
 using namespace dimensions;  // NOLINT
@@ -102,6 +153,13 @@ struct ViaWidget : public SIMWidget {
 
         menu->addChild(new MenuSeparator);
         menu->addChild(module->createExpandableSubmenu(this));
+        menu->addChild(new MenuSeparator);
+        menu->addChild(bus::createMenuItem(
+            "Receive from bus", [module]() { return module->busIn.getSelected(); },
+            [module](int index) { module->selectReceiveBus(index); }));
+        menu->addChild(bus::createMenuItem(
+            "Send to bus", [module]() { return module->busOut.getSelected(); },
+            [module](int index) { module->selectSendBus(index); }));
     }
 };
 
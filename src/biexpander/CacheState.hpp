@@ -1,56 +1,72 @@
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
 #include <rack.hpp>
 
+/// @brief Slowest and fastest rate at which params are polled for changes made without a
+/// notification (e.g. by other modules or MIDI mapping)
 const float PARAM_CHECK_RATE = 29.0F;
-/// @brief equality operator for Param for cache comparison
-inline bool operator!=(const rack::engine::Param& lhs, const rack::engine::Param& rhs)
-{
-    return lhs.value != rhs.value;
-}
-// @brief equality operator for Input for cache comparison
-inline bool operator!=(const rack::engine::Input& lhs, const rack::engine::Input& rhs)
-{
-    // Check number of channels
-    if (lhs.channels != rhs.channels) { return true; }  // NOLINT
-    // Check individual channel voltages
-    for (uint8_t i = 0; i < lhs.channels; i++) {                  // NOLINT
-        if (lhs.voltages[i] != rhs.voltages[i]) { return true; }  // NOLINT
-    }
-    return false;
-}
+const float PARAM_CHECK_RATE_FAST = 1000.0F;
+/// @brief Bitmask value meaning every index changed
+constexpr uint16_t ALL_INDICES = 0xFFFF;
 
 /// @brief Mixin class for indicating of invalid cache
 /// @details This class is used internally by Connectable
 class CacheState {
    public:
-    /// @brief Pass inputs that don't invalidate the internal state of the adapter
-    void setIgnoreInputIds(std::vector<size_t> ignoreInputIds)
-    {
-        // Pass inputs that don't invalidate readBuffer
-        inputIndices.clear();
-        for (size_t i = 0; i < static_cast<size_t>(module->getNumInputs()); i++) {
-            if (std::find(ignoreInputIds.begin(), ignoreInputIds.end(), i) ==
-                ignoreInputIds.end()) {
-                // if we don't find the index in the ignore list, we add it to the inputIndices
-                inputIndices.push_back(i);
-            }
+    /// @brief Sets the inputs and parameters that don't invalidate the internal state of the
+    /// adapter and allocates the snapshot for the remaining ones
+    void configure(const std::vector<size_t>& ignoreInputIds,
+                   const std::vector<size_t>& ignoreParamIds)
+    {
+        assert(module->getNumInputs() <= 64 && module->getNumParams() <= 64);  // NOLINT
+        watchedInputs = lowBits(module->getNumInputs());
+        for (const size_t id : ignoreInputIds) {
+            watchedInputs &= ~(uint64_t{1} << id);
+        }
+        watchedParams = lowBits(module->getNumParams());
+        for (const size_t id : ignoreParamIds) {
+            watchedParams &= ~(uint64_t{1} << id);
         }
+        // One allocation: voltages[inputs][16], then params, then the channel counts
+        const int inputs = std::popcount(watchedInputs);
+        const int params = std::popcount(watchedParams);
+        const int voltageBlocks = inputs * rack::PORT_MAX_CHANNELS / 4;
+        const int paramBlocks = (params + 3) / 4;
+        const int channelBlocks = (inputs + 15) / 16;
+        snapshot.reset(new rack::simd::float_4[voltageBlocks + paramBlocks + channelBlocks]());
+        snapshotVoltages = reinterpret_cast<float*>(snapshot.get());                 // NOLINT
+        snapshotParams = reinterpret_cast<float*>(snapshot.get() + voltageBlocks);  // NOLINT
+        snapshotChannels =
+            reinterpret_cast<uint8_t*>(snapshot.get() + voltageBlocks + paramBlocks);  // NOLINT
     }
-    /// @brief Pass parameters that don't invalidate the internal state of the adapter
-    void setIgnoreParamIds(std::vector<size_t> ignoreParamIds)
+    /// @brief Keeps track of the connected inputs, call this from onPortChange
+    void setInputConnected(int inputId, bool connected)
     {
-        paramIndices.clear();
-        for (size_t i = 0; i < static_cast<size_t>(module->getNumParams()); i++) {
-            if (std::find(ignoreParamIds.begin(), ignoreParamIds.end(), i) ==
-                ignoreParamIds.end()) {
-                paramIndices.push_back(i);
-            }
-        }
+        const uint64_t bit = uint64_t{1} << inputId;
+        connectedInputs = connected ? (connectedInputs | bit) : (connectedInputs & ~bit);
+        setInputDirty();
     }
 
     explicit CacheState(rack::Module* module) : module(module)
     {
-        float sampleRate = APP->engine->getSampleRate();
-        paramDivider.setDivision(sampleRate / PARAM_CHECK_RATE);
+        setSampleRate(APP->engine->getSampleRate());
+    }
+
+    /// @brief Recomputes the param polling rates, call this on sample rate change
+    void setSampleRate(float sampleRate)
+    {
+        slowDivision = std::max(static_cast<uint32_t>(sampleRate / PARAM_CHECK_RATE), 1U);
+        fastDivision = std::max(static_cast<uint32_t>(sampleRate / PARAM_CHECK_RATE_FAST), 1U);
+        paramDivider.setDivision(slowDivision);
+    }
+
+    /// @brief Signals a param change so that it is picked up on the next sample without polling
+    /// @details Called from the UI thread by biexpand::CachedParamQuantity
+    void notifyParamChange()
+    {
+        paramGeneration.fetch_add(1, std::memory_order_relaxed);
     }
 
     /// @brief Just returns the dirty flag without updating the cache
@@ -67,23 +83,29 @@ class CacheState {
         if (isDirty()) { return true; }
         // With cache enabled, this block is the main CPU consumer
         {
-            // Compare inputs (using the != operator defined elsewhere in this file)
-            if (std::any_of(inputIndices.begin(), inputIndices.end(), [&](int inputIndice) {
-                    return module->inputs[inputIndice] != inputCache[inputIndice];
-                })) {
+            // Only connected watched inputs can change. Nothing connected is a single branch.
+            const uint64_t inputs = connectedInputs & watchedInputs;
+            if (inputs && changedInputs(inputs)) {
                 dirtyInputs = true;
                 return true;
             }
-            // Is it time to check the params?
+            // Params changed through their ParamQuantity are notified
+            if (paramGeneration.load(std::memory_order_relaxed) != seenParamGeneration) {
+                dirtyParams = true;
+                return true;
+            }
+            // Is it time to poll the params?
             if (paramDivider.process()) {
                 // Check if any parameter has changed
                 // For all indices in paramIndices (the ones that are not ignored)
-                if (std::any_of(paramIndices.begin(), paramIndices.end(), [&](int paramIndice) {
-                        return module->params[paramIndice] != paramCache[paramIndice];
-                    })) {
+                if (changedParams(watchedParams)) {
+                    // Someone changes params behind our back, poll faster for a while
+                    paramDivider.setDivision(
+                        std::max(paramDivider.getDivision() / 2, fastDivision));
                     dirtyParams = true;
                     return true;
                 }
+                paramDivider.setDivision(std::min(paramDivider.getDivision() * 2, slowDivision));
             }
         }
         // If none of the above conditions are met, the adapter is not dirty
@@ -92,24 +114,84 @@ class CacheState {
     void setParamDirty()
     {
         dirtyParams = true;
+        invalidated = true;
     }
     void setInputDirty()
     {
         dirtyInputs = true;
+        invalidated = true;
+    }
+    /// @brief Bitmask of the watched params among the first 16 that differ from the cache
+    /// @details All bits are set when the cache was invalidated or a param beyond the first 16
+    /// changed. Unlike needsRefreshing() this compares right away, regardless of the check rate.
+    uint16_t getChangedParams() const
+    {
+        if (invalidated) { return ALL_INDICES; }
+        if (changedParams(watchedParams & ~lowBits(16))) { return ALL_INDICES; }
+        uint16_t changed = 0;
+        for (uint64_t mask = watchedParams & lowBits(16); mask; mask &= mask - 1) {
+            const int id = std::countr_zero(mask);
+            if (changedParams(uint64_t{1} << id)) { changed |= 1U << id; }
+        }
+        return changed;
+    }
+    /// @brief Bitmask of the watched inputs among the first 16 that differ from the cache
+    uint16_t getChangedInputs() const
+    {
+        if (invalidated) { return ALL_INDICES; }
+        const uint64_t inputs = connectedInputs & watchedInputs;
+        if (changedInputs(inputs & ~lowBits(16))) { return ALL_INDICES; }
+        uint16_t changed = 0;
+        for (uint64_t mask = inputs & lowBits(16); mask; mask &= mask - 1) {
+            const int id = std::countr_zero(mask);
+            if (changedInputs(uint64_t{1} << id)) { changed |= 1U << id; }
+        }
+        return changed;
+    }
+    /// @brief Bitmask of the channels whose watched inputs changed since the last refresh
+    /// @details Parameters, connection changes, channel count changes and monophonic inputs
+    /// affect every channel. Used by poly chains to only transform the channels that changed.
+    uint16_t getDirtyChannels() const
+    {
+        constexpr uint16_t allChannels = 0xFFFF;
+        if (dirtyParams || invalidated) { return allChannels; }
+        uint16_t dirtyChannels = 0;
+        for (uint64_t mask = connectedInputs & watchedInputs; mask; mask &= mask - 1) {
+            const int id = std::countr_zero(mask);
+            const int slot = inputSlot(id);
+            const uint8_t channels = module->inputs[id].channels;
+            if (channels != snapshotChannels[slot]) { return allChannels; }
+            const uint16_t changed = changedChannels(id, slot) & lowBits(channels);
+            if (changed && channels == 1) { return allChannels; }
+            dirtyChannels |= changed;
+        }
+        return dirtyChannels;
     }
     void paramRefresh() const
     {
-        paramCache = module->params;
+        int slot = 0;
+        for (uint64_t mask = watchedParams; mask; mask &= mask - 1) {
+            snapshotParams[slot++] = module->params[std::countr_zero(mask)].value;
+        }
     }
     void inputRefresh() const
     {
-        inputCache = module->inputs;
+        int slot = 0;
+        for (uint64_t mask = watchedInputs; mask; mask &= mask - 1, slot++) {
+            const rack::engine::Input& input = module->inputs[std::countr_zero(mask)];
+            float* voltages = snapshotVoltages + slot * rack::PORT_MAX_CHANNELS;
+            for (int channel = 0; channel < rack::PORT_MAX_CHANNELS; channel += 4) {
+                rack::simd::float_4::load(input.voltages + channel).store(voltages + channel);
+            }
+            snapshotChannels[slot] = input.channels;
+        }
     }
     /// @brief Updates the cache with the current state of the module and resets the dirty flag
     void refresh()
     {
         // An expensive copy step, but only if things change
         if (dirtyParams) {
+            seenParamGeneration = paramGeneration.load(std::memory_order_relaxed);
             paramRefresh();
             dirtyParams = false;
             paramDivider.reset();
@@ -118,15 +200,74 @@ class CacheState {
             inputRefresh();
             dirtyInputs = false;
         }
+        invalidated = false;
     }
 
    private:
     rack::Module* module;
+    std::atomic<uint32_t> paramGeneration{0};
+    uint32_t seenParamGeneration = 0;
+    uint32_t slowDivision = 1;
+    uint32_t fastDivision = 1;
     bool dirtyParams = true;
     bool dirtyInputs = true;
-    mutable std::vector<rack::Param> paramCache;
-    mutable std::vector<rack::Input> inputCache;
-    std::vector<size_t> paramIndices;
-    std::vector<size_t> inputIndices;
+    /// @brief Set when the cache was invalidated as a whole, e.g. on a connection change
+    bool invalidated = true;
+    /// @brief Bit i is set for param/input i when it invalidates the cache
+    uint64_t watchedParams = 0;
+    uint64_t watchedInputs = 0;
+    /// @brief Bit i is set when input i is connected. Maintained by setInputConnected().
+    uint64_t connectedInputs = 0;
+    /// @brief Snapshot of the watched inputs and params as of the last refresh, packed by
+    /// slot (the rank of the id among the watched ones). The pointers point into `snapshot`.
+    std::unique_ptr<rack::simd::float_4[]> snapshot;
+    float* snapshotVoltages = nullptr;
+    float* snapshotParams = nullptr;
+    uint8_t* snapshotChannels = nullptr;
     mutable rack::dsp::ClockDivider paramDivider;
+
+    static constexpr uint64_t lowBits(int count)
+    {
+        return count >= 64 ? ~uint64_t{0} : (uint64_t{1} << count) - 1;
+    }
+    int inputSlot(int id) const
+    {
+        return std::popcount(watchedInputs & lowBits(id));
+    }
+    int paramSlot(int id) const
+    {
+        return std::popcount(watchedParams & lowBits(id));
+    }
+    /// @brief Bitmask of the channels of a watched input that differ from the snapshot
+    uint16_t changedChannels(int id, int slot) const
+    {
+        const float* current = module->inputs[id].voltages;
+        const float* cached = snapshotVoltages + slot * rack::PORT_MAX_CHANNELS;
+        int changed = 0;
+        for (int channel = 0; channel < rack::PORT_MAX_CHANNELS; channel += 4) {
+            changed |= rack::simd::movemask(rack::simd::float_4::load(current + channel) !=
+                                            rack::simd::float_4::load(cached + channel))
+                       << channel;
+        }
+        return changed;
+    }
+    bool changedParams(uint64_t mask) const
+    {
+        for (; mask; mask &= mask - 1) {
+            const int id = std::countr_zero(mask);
+            if (module->params[id].value != snapshotParams[paramSlot(id)]) { return true; }
+        }
+        return false;
+    }
+    bool changedInputs(uint64_t mask) const
+    {
+        for (; mask; mask &= mask - 1) {
+            const int id = std::countr_zero(mask);
+            const int slot = inputSlot(id);
+            const uint8_t channels = module->inputs[id].channels;
+            if (channels != snapshotChannels[slot]) { return true; }
+            if (changedChannels(id, slot) & lowBits(channels)) { return true; }
+        }
+        return false;
+    }
 };
\ No newline at end of file
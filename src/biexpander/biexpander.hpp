@@ -1,17 +1,23 @@
 
 // #define DEBUGSTATE
 #pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
 #include <functional>
+#include <initializer_list>
 #ifdef DEBUGSTATE
 #include <iostream>
 #endif
 #include <iterator>
-#include <map>
 #include <rack.hpp>
 #include <set>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include "../Debug.hpp"
+#include "../constants.hpp"
 #include "CacheState.hpp"
 #include "ConnectionLights.hpp"
 #include "ModuleInstantiationMenu.hpp"
@@ -49,6 +55,17 @@ class Connectable : public rack::engine::Module, public DebugState {
 class Connectable : public rack::engine::Module {
 #endif
    public:
+    /// @brief Capability bits of a Connectable, so that the chain code can tell modules apart
+    /// with integer compares instead of RTTI
+    enum Capability : uint8_t {
+        EXPANDABLE = 1U << 0U,
+        EXPANDER = 1U << 1U,
+        /// @brief Set for expanders that attach to the right of an expandable
+        RIGHT_SIDE = 1U << 2U,
+        FLOAT_DATA = 1U << 3U,
+        BOOL_DATA = 1U << 4U,
+    };
+
     Connectable() : connectionLights(this), cacheState(this) {}
 
     /// @brief call this after configuring inputs, outputs and params of the module in its
@@ -57,17 +74,28 @@ class Connectable : public rack::engine::Module {
     /// adapter
     /// @param ignoreParamIds indices of parameters that don't invalidate the internal state of the
     /// adapter
-    void configCache(std::vector<size_t> ignoreInputIds = {},
-                     std::vector<size_t> ignoreParamIds = {})
+    void configCache(const std::vector<size_t>& ignoreInputIds = {},
+                     const std::vector<size_t>& ignoreParamIds = {})
+    {
+        cacheState.configure(ignoreInputIds, ignoreParamIds);
+    }
+
+    bool hasCapabilities(uint8_t mask) const
     {
-        cacheState.setIgnoreInputIds(std::move(ignoreInputIds));
-        cacheState.setIgnoreParamIds(std::move(ignoreParamIds));
+        return (capabilities & mask) == mask;
     }
 
     bool isBeingRemoved() const
     {
         return beingRemoved;
     }
+    /// @brief Bumped whenever the neighbours of a Connectable change or one is removed
+    /// @details Lets code that looks beyond its own chain (Log<sup>x</sup>) cache what it found
+    /// until the layout changes. Bumped by the chain events on the engine thread.
+    static uint32_t getLayoutGeneration()
+    {
+        return layoutGeneration.load(std::memory_order_relaxed);
+    }
     void setBeingRemoved()
     {
         beingRemoved = true;
@@ -76,14 +104,53 @@ class Connectable : public rack::engine::Module {
     /// @brief Invalidate the cache of a connectable when a port changes
     void onPortChange(const rack::Module::PortChangeEvent& e) override
     {
-        cacheState.setInputDirty();
+        if (e.type == rack::engine::Port::INPUT) {
+            cacheState.setInputConnected(e.portId, e.connecting);
+        }
+        else {
+            cacheState.setInputDirty();
+        }
+    }
+    void onSampleRateChange(const rack::Module::SampleRateChangeEvent& e) override
+    {
+        rack::Module::onSampleRateChange(e);
+        cacheState.setSampleRate(e.sampleRate);
     }
 
     ConnectionLights connectionLights;  // NOLINT
     CacheState cacheState;              // NOLINT
 
+   protected:
+    uint8_t capabilities = 0;
+
+    static void bumpLayoutGeneration()
+    {
+        layoutGeneration.fetch_add(1, std::memory_order_relaxed);
+    }
+
    private:
     bool beingRemoved = false;
+    inline static std::atomic<uint32_t> layoutGeneration{0};
+};
+
+/// @brief ParamQuantity notifying the CacheState of its Connectable on every change
+/// @details Use it (or derive from it) in configParam()/configSwitch() of Connectables so that
+/// knob moves are seen on the next sample instead of on the next poll of the params. Only for
+/// params of a Connectable, the module is not type checked.
+template <typename TBase = rack::ParamQuantity>
+struct CachedParamQuantity : TBase {
+    void setValue(float value) override
+    {
+        TBase::setValue(value);
+        notifyChange();
+    }
+
+   protected:
+    void notifyChange()
+    {
+        auto* connectable = static_cast<Connectable*>(this->module);
+        if (connectable) { connectable->cacheState.notifyParamChange(); }
+    }
 };
 // forward declaration of specilized templates for BiExpander friendship
 template <typename F>
@@ -107,11 +174,15 @@ class BiExpander : public Connectable {
         dbg << "Slot count: " << changeSignal.slot_count() << std::endl;
     }
 #endif
-    explicit BiExpander(bool right) : imright(right) {}
+    explicit BiExpander(bool right) : imright(right)
+    {
+        capabilities = EXPANDER | (right ? RIGHT_SIDE : 0U);
+    }
     void onRemove() override
     {
         DEBUG("BiExpander(%s)::onRemove", model->name.c_str());
         setBeingRemoved();
+        bumpLayoutGeneration();
         changeSignal(imright);
         assert(changeSignal.slot_count() == 0);
     }
@@ -120,6 +191,7 @@ class BiExpander : public Connectable {
     {
         DEBUG("BiExpander(%s)::onExpanderChange %s", model->name.c_str(),
               std::to_string(e.side).c_str());
+        bumpLayoutGeneration();
         if ((imright && e.side) || (!imright && !e.side)) {
             auto& currentExpander = imright ? this->rightExpander : this->leftExpander;
             auto& prevModule = imright ? prevRightModule : prevLeftModule;
@@ -168,9 +240,72 @@ class Adapter {
     }
     virtual void transformInPlace(FloatIter first, FloatIter last, int channel) const {}
     virtual void transformInPlace(BoolIter first, BoolIter last, int channel) const {}
+    /// @brief Point queries: resolve a single output element without transforming the buffer
+    /// @details Sequencers that only read the current step use these to follow a modulated chain
+    /// without rebuilding the whole buffer. Adapters answering them override canQuery().
+    virtual bool canQuery() const
+    {
+        return false;
+    }
+    /// @brief canQuery() for gate buffers, for adapters that change gates in other ways
+    virtual bool canQueryGates() const
+    {
+        return canQuery();
+    }
+    /// @brief Length of the output for an input of inputLength elements
+    virtual int queryLength(int inputLength, int /*channel*/) const
+    {
+        return inputLength;
+    }
+    /// @brief Index of the input element that output element index is taken from
+    virtual int querySource(int index, int /*inputLength*/, int /*channel*/) const
+    {
+        return index;
+    }
+    /// @brief Value of output element index, given the value of its source element
+    virtual float queryValue(int /*index*/, float source, int /*channel*/) const
+    {
+        return source;
+    }
+    virtual bool queryValue(int /*index*/, bool source, int /*channel*/) const
+    {
+        return source;
+    }
+    /// @brief Whether queryLength()/querySource() differ from the identity for this input
+    virtual bool reordersIndices(int /*inputLength*/, int /*channel*/) const
+    {
+        return true;
+    }
+    /// @brief Bitmask of the output elements whose value queryValue() changes
+    virtual uint16_t valueMask(int /*length*/, int /*channel*/) const
+    {
+        return 0;
+    }
+    /// @brief Maps the indices of changed input elements to the output elements they affect
+    /// @details Includes the elements the adapter changed itself. Only used on adapters that
+    /// canQuery(), the default marks every element as changed.
+    virtual uint16_t mapDirty(uint16_t /*dirty*/, int /*inputLength*/, int /*channel*/) const
+    {
+        return ALL_INDICES;
+    }
+
+   protected:
+    /// @brief mapDirty() for adapters that only reorder or select elements
+    uint16_t mapDirtyBySource(uint16_t dirty, int inputLength, int channel) const
+    {
+        uint16_t mapped = 0;
+        const int outputLength = queryLength(inputLength, channel);
+        for (int i = 0; i < outputLength; ++i) {
+            if (dirty & (1U << querySource(i, inputLength, channel))) { mapped |= 1U << i; }
+        }
+        return mapped;
+    }
+
+   public:
     virtual void setInputDirty() = 0;
     virtual void setParamDirty() = 0;
     virtual bool needsRefresh() const = 0;
+    virtual uint16_t getDirtyChannels() const = 0;
     virtual void refresh() = 0;
 };
 
@@ -212,6 +347,10 @@ class BaseAdapter : public Adapter {
     {
         return ptr->cacheState.needsRefreshing();
     }
+    uint16_t getDirtyChannels() const override
+    {
+        return ptr->cacheState.getDirtyChannels();
+    }
     void refresh() override
     {
         ptr->cacheState.refresh();
@@ -241,7 +380,32 @@ class BaseAdapter : public Adapter {
     std::function<float(float)> floatTransformFunction;
 };
 
-using AdapterMap = std::map<rack::Model*, Adapter*>;
+/// @brief Compatible models and their adapters
+/// @details A flat table in declaration order, a lookup is a handful of pointer compares.
+class AdapterMap {
+   public:
+    using Entry = std::pair<rack::Model*, Adapter*>;
+    AdapterMap(std::initializer_list<Entry> entries) : entries(entries) {}
+    /// @brief The adapter for model, nullptr if the model is not compatible
+    Adapter* find(const rack::Model* model) const
+    {
+        for (const Entry& entry : entries) {
+            if (entry.first == model) { return entry.second; }
+        }
+        return nullptr;
+    }
+    std::vector<Entry>::const_iterator begin() const
+    {
+        return entries.begin();
+    }
+    std::vector<Entry>::const_iterator end() const
+    {
+        return entries.end();
+    }
+
+   private:
+    std::vector<Entry> entries;
+};
 
 /// @brief Expandable is a module that can have expanders attached to it.
 /// @param F is the underlying datatype (float or bool for now)
@@ -251,6 +415,7 @@ class Expandable : public Connectable {
     Expandable(AdapterMap leftAdapters, AdapterMap rightAdapters)
         : leftModelsAdapters(std::move(leftAdapters)), rightModelsAdapters(std::move(rightAdapters))
     {
+        capabilities = EXPANDABLE | (std::is_same_v<F, bool> ? BOOL_DATA : FLOAT_DATA);
         v1.resize(16);
         v2.resize(16);
     };
@@ -297,6 +462,7 @@ class Expandable : public Connectable {
     {
         DEBUG("BiExpander(%s)::onRemove", model->name.c_str());
         setBeingRemoved();
+        bumpLayoutGeneration();
         disconnectExpanders(true, rightExpanders.begin(), rightExpanders.end());
         disconnectExpanders(false, leftExpanders.begin(), leftExpanders.end());
     }
@@ -304,6 +470,12 @@ class Expandable : public Connectable {
     {
         DEBUG("Expandable(%s)::onExpanderChange %s", model->name.c_str(),
               std::to_string(e.side).c_str());
+        bumpLayoutGeneration();
+        if (chainPending) {
+            // Still loading, the chain is resolved once by resolvePendingChain()
+            pendingSides[e.side ? 1 : 0] = true;
+            return;
+        }
         if (e.side) {  //&& (prevRightModule != this->rightExpander.module)) {
             refreshExpanders(true);
             prevRightModule = this->rightExpander.module;
@@ -314,6 +486,12 @@ class Expandable : public Connectable {
         }
     };
 
+    void processBypass(const ProcessArgs& args) override
+    {
+        resolvePendingChain();
+        Connectable::processBypass(args);
+    }
+
     /// @brief Override onUpdateExpanders instead of onExpanderChange() if you need to do something
     /// when the expander chain, or to avoid the VCV Bug (<=v2.4.1) where onExpanderChange is not
     /// called when the expander is deleted.
@@ -331,16 +509,15 @@ class Expandable : public Connectable {
             DEBUG("Expander is in smart mode. Bail out.");
             return false;
         }
-        const auto* cadapters = right ? &rightModelsAdapters : &leftModelsAdapters;
-        auto adapter = cadapters->find(expander->model);
-        if (adapter == cadapters->end()) { return false; }  // Not compatible
+        Adapter* adapter = (right ? rightModelsAdapters : leftModelsAdapters).find(expander->model);
+        if (!adapter) { return false; }  // Not compatible
         auto* expanders = right ? &rightExpanders : &leftExpanders;
         auto* adapters = right ? &rightAdapters : &leftAdapters;
         if (std::find(expanders->begin(), expanders->end(), expander) != expanders->end()) {
             return false;
         }
         expanders->push_back(expander);
-        adapters->push_back(adapter->second);
+        adapters->push_back(adapter);
         // assert(expander->changeSignal.slot_count() == 0); // Disabled because of smartmode
         expander->changeSignal.connect(&Expandable::refreshExpanders, this);
 
@@ -349,7 +526,7 @@ class Expandable : public Connectable {
         DEBUG("Turning on the %s light of %s", !right ? "right" : "left",
               expander->model->name.c_str());
         expander->connectionLights.setLight(!right, true);
-        adapter->second->setPtr(expander);
+        adapter->setPtr(expander);
         return true;
     }
 
@@ -359,7 +536,6 @@ class Expandable : public Connectable {
         auto* prevModule = right ? &prevRightModule : &prevLeftModule;
         auto* expanders = right ? &rightExpanders : &leftExpanders;
         auto* adapters = right ? &rightAdapters : &leftAdapters;
-        auto* modelsAdapters = right ? &rightModelsAdapters : &leftModelsAdapters;
         *prevModule = nullptr;
         // Tell the disconnected module to disconnect from 'this' expandable
         expander->changeSignal.disconnect(&Expandable::refreshExpanders, this);
@@ -374,13 +550,10 @@ class Expandable : public Connectable {
         expanders->erase(std::remove(expanders->begin(), expanders->end(), expander),
                          expanders->end());
         // find and remove the adapter from the list
-        auto adapter = right ? rightModelsAdapters.find(expander->model)
-                             : leftModelsAdapters.find(expander->model);
-        adapters->erase(std::remove(adapters->begin(), adapters->end(), adapter->second),
-                        adapters->end());
+        Adapter* adapter = (right ? rightModelsAdapters : leftModelsAdapters).find(expander->model);
+        adapters->erase(std::remove(adapters->begin(), adapters->end(), adapter), adapters->end());
         // Set the adapter to nullptr
-        auto it = modelsAdapters->find(expander->model);
-        if (it != modelsAdapters->end()) { it->second->setPtr(nullptr); }
+        if (adapter) { adapter->setPtr(nullptr); }
     }
 
     void disconnectExpanders(bool right,
@@ -423,8 +596,8 @@ class Expandable : public Connectable {
 
     rack::MenuItem* createExpandableSubmenu(rack::ModuleWidget* moduleWidget)
     {
-        const auto* expandable = dynamic_cast<Expandable*>(moduleWidget->module);
-        assert(expandable != nullptr);
+        assert(moduleWidget->module == this);  // NOLINT
+        const auto* expandable = this;
         auto hasModel = [expandable](bool right, const std::string& name) {
             auto expanders =
                 right ? expandable->getRightExpanders() : expandable->getLeftExpanders();
@@ -466,6 +639,21 @@ class Expandable : public Connectable {
     };
 
    protected:
+    /// @brief Resolves the expander chains once, call this at the start of process()
+    /// @details Until the first process() the expander changes are only recorded. On patch load
+    /// every module of a chain reports its neighbours one by one, resolving on each of those
+    /// events would rebuild the chain over and over.
+    void resolvePendingChain()
+    {
+        if (!chainPending) { return; }
+        chainPending = false;
+        for (const bool right : {false, true}) {
+            if (!pendingSides[right ? 1 : 0]) { continue; }
+            refreshExpanders(right);
+            (right ? prevRightModule : prevLeftModule) =
+                right ? this->rightExpander.module : this->leftExpander.module;
+        }
+    }
     bool dirtyAdapters()
     {
         for (const auto* adapter : leftAdapters) {
@@ -477,11 +665,26 @@ class Expandable : public Connectable {
         }
         return false;
     }
+    /// @brief Bitmask of the poly chain channels affected by changes in the adapters
+    uint16_t dirtyAdapterChannels() const
+    {
+        uint16_t channels = 0;
+        for (const auto* adapter : leftAdapters) {
+            channels |= adapter->getDirtyChannels();
+        }
+        for (const auto* adapter : rightAdapters) {  // NOLINT
+            channels |= adapter->getDirtyChannels();
+        }
+        return channels;
+    }
 
    private:
     friend BiExpander;
     Module* prevLeftModule = nullptr;
     Module* prevRightModule = nullptr;
+    /// @brief Set until the first process(), see resolvePendingChain()
+    bool chainPending = true;
+    std::array<bool, 2> pendingSides{};
     /// @brief vector of pointers to expanders that represents the order of expanders and that
     /// is used to keep track of changes in the expander chain
     std::vector<BiExpander*> leftExpanders;
@@ -490,6 +693,11 @@ class Expandable : public Connectable {
     AdapterMap leftModelsAdapters;
     AdapterMap rightModelsAdapters;
     /// @brief vector of pointers to adapters that represents the order of expanders
+    /// @details Changed by the chain events only: onExpanderChange() and onRemove(), and
+    /// resolvePendingChain() at the start of process(). Rack runs the expander events from
+    /// Engine::stepBlock() before it steps the modules and removes modules under the exclusive
+    /// engine lock, so they are never concurrent with process(). No snapshot or lock is needed,
+    /// and adapters are nulled and erased in the same event.
     std::vector<Adapter*> leftAdapters;
     std::vector<Adapter*> rightAdapters;
 
@@ -501,16 +709,18 @@ class Expandable : public Connectable {
         std::function<BiExpander*(Connectable*)> nextModule;
 
         nextModule = [this, right](Connectable* currModule) -> BiExpander* {
-            auto* expander = right ? dynamic_cast<BiExpander*>(currModule->rightExpander.module)
-                                   : dynamic_cast<BiExpander*>(currModule->leftExpander.module);
-            if (!expander || expander->isBeingRemoved()) { return nullptr; }
-            auto* modelsAdapters = right ? &rightModelsAdapters : &leftModelsAdapters;
-            auto it = modelsAdapters->find(expander->model);
-            if (it == modelsAdapters->end()) { return nullptr; }
+            // Only models in the adapter table are BiExpanders, no RTTI needed
+            Module* module = right ? currModule->rightExpander.module
+                                   : currModule->leftExpander.module;
+            const AdapterMap& modelsAdapters = right ? rightModelsAdapters : leftModelsAdapters;
+            if (!module || !modelsAdapters.find(module->model)) { return nullptr; }
+            auto* expander = static_cast<BiExpander*>(module);
+            assert(expander->hasCapabilities(EXPANDER));  // NOLINT
+            if (expander->isBeingRemoved()) { return nullptr; }
             return expander;
         };
         expanders = right ? &rightExpanders : &leftExpanders;
-        BiExpander* currModule = nextModule(dynamic_cast<Connectable*>(this));
+        BiExpander* currModule = nextModule(this);
         // Don't touch the expanders that are unchanged
         // Keep list of connected models to avoid connecting the same model twice
         std::set<rack::plugin::Model*>
@@ -599,7 +809,202 @@ class Expandable : public Connectable {
         }
     }
 
+    /// @brief Transforms readBuffer() through the left adapters, see transformAdapters()
+    void transformLeftAdapters()
+    {
+        transformAdapters(leftAdapters);
+    }
+    /// @brief Transforms readBuffer() through the right adapters, see transformAdapters()
+    void transformRightAdapters()
+    {
+        transformAdapters(rightAdapters);
+    }
+
+    /// @brief Whether adapter is disconnected or answers point queries for buffers of F
+    static bool answersQueries(const Adapter& adapter)
+    {
+        if (!adapter) { return true; }
+        if constexpr (std::is_same_v<F, bool>) { return adapter.canQueryGates(); }
+        else {
+            return adapter.canQuery();
+        }
+    }
+    /// @brief True when every connected left adapter answers point queries
+    bool canQueryChain() const
+    {
+        if (leftAdapters.size() > MAX_QUERY_DEPTH) { return false; }
+        return std::all_of(leftAdapters.begin(), leftAdapters.end(),
+                           [](const Adapter* adapter) { return answersQueries(*adapter); });
+    }
+    /// @brief Length readBuffer() would have after the left adapters, without transforming it
+    int queryChainLength(int channel) const
+    {
+        int length = static_cast<int>(readBuffer().size());
+        for (const Adapter* adapter : leftAdapters) {
+            if (*adapter) { length = adapter->queryLength(length, channel); }
+        }
+        return length;
+    }
+    /// @brief Element index of readBuffer() after the left adapters, without transforming it
+    /// @details Maps index back through the chain to an element of readBuffer() and applies the
+    /// value transformations of the adapters on the way out. Requires canQueryChain().
+    F queryChain(int index, int channel)
+    {
+        const size_t depth = leftAdapters.size();
+        std::array<int, MAX_QUERY_DEPTH + 1> lengths{};
+        std::array<int, MAX_QUERY_DEPTH + 1> indices{};
+        lengths[0] = static_cast<int>(readBuffer().size());
+        for (size_t i = 0; i < depth; ++i) {
+            const Adapter& adapter = *leftAdapters[i];
+            lengths[i + 1] = adapter ? adapter.queryLength(lengths[i], channel) : lengths[i];
+        }
+        indices[depth] = index;
+        for (size_t i = depth; i > 0; --i) {
+            const Adapter& adapter = *leftAdapters[i - 1];
+            indices[i - 1] =
+                adapter ? adapter.querySource(indices[i], lengths[i - 1], channel) : indices[i];
+        }
+        F value = readBuffer()[indices[0]];
+        for (size_t i = 0; i < depth; ++i) {
+            const Adapter& adapter = *leftAdapters[i];
+            if (adapter) { value = adapter.queryValue(indices[i + 1], value, channel); }
+        }
+        return value;
+    }
+    /// @brief Maps the indices of readBuffer() that changed to the chain output they affect
+    /// @details Requires canQueryChain(). Changes made by the adapters themselves are included.
+    uint16_t mapDirtyChain(uint16_t dirty, int channel) const
+    {
+        int length = static_cast<int>(readBuffer().size());
+        for (const Adapter* adapter : leftAdapters) {
+            if (!*adapter) { continue; }
+            dirty = adapter->mapDirty(dirty, length, channel);
+            if (dirty == ALL_INDICES) { return dirty; }
+            length = adapter->queryLength(length, channel);
+        }
+        return dirty;
+    }
+    /// @brief Marks the left adapters as processed without transforming the buffer
+    /// @details needsRefresh() is called on each so the changes it finds end up in the cache.
+    void refreshLeftAdapters()
+    {
+        for (Adapter* adapter : leftAdapters) {
+            if (!*adapter) { continue; }
+            adapter->needsRefresh();
+            adapter->refresh();
+        }
+    }
+
+    /// @brief Transforms readBuffer() through the expander chain once per poly chain channel
+    /// @details Each channel in channelMask gets its own buffer in which every adapter is
+    /// evaluated with that channel, so CV on a channel of an expander only affects that voice.
+    /// Channels outside channelMask keep their previous result.
+    /// @param onLeftDone Called with (channel, first, length) between the left and right adapters,
+    /// e.g. to pick up the values for Out<sup>x</sup> before it cuts them.
+    template <typename OnLeftDone>
+    void transformPolyChain(uint16_t channelMask, OnLeftDone&& onLeftDone)
+    {
+        for (int channel = 0; channel < constants::NUM_CHANNELS; ++channel) {
+            if (!(channelMask & (1U << channel))) { continue; }
+            int length = static_cast<int>(readBuffer().size());
+            std::copy(readBuffer().begin(), readBuffer().end(),
+                      polySlot(channel, polyCurrent[channel]));
+            for (Adapter* adapter : leftAdapters) {
+                transformPolySlot(*adapter, channel, length);
+            }
+            onLeftDone(channel, polySlot(channel, polyCurrent[channel]), length);
+            for (Adapter* adapter : rightAdapters) {
+                transformPolySlot(*adapter, channel, length);
+            }
+            polyLengths[channel] = length;
+        }
+        for (Adapter* adapter : leftAdapters) {
+            if (*adapter) { adapter->refresh(); }
+        }
+        for (Adapter* adapter : rightAdapters) {
+            if (*adapter) { adapter->refresh(); }
+        }
+    }
+    int polyBufferSize(int channel) const
+    {
+        return polyLengths[channel];
+    }
+    F polyBufferValue(int channel, int index) const
+    {
+        return *(polySlot(channel, polyCurrent[channel]) + index);
+    }
+
    private:
+    static constexpr size_t MAX_QUERY_DEPTH = 8;
+    /// @brief Runs the adapters one by one, or fused into a single pass when they all answer
+    /// point queries
+    /// @details Decided on every call, an adapter stops answering queries in some modes, like
+    /// In<sup>x</sup> in insert mode. Asking is cheaper than tracking the modes.
+    void transformAdapters(const std::vector<Adapter*>& adapters)
+    {
+        const bool fusable =
+            std::all_of(adapters.begin(), adapters.end(),
+                        [](const Adapter* adapter) { return answersQueries(*adapter); });
+        if (!fusable) {
+            for (Adapter* adapter : adapters) {
+                transform(*adapter);
+            }
+            return;
+        }
+        transformFused(adapters);
+        for (Adapter* adapter : adapters) {
+            if (*adapter) { adapter->refresh(); }
+        }
+    }
+    /// @brief All adapters in one pass over readBuffer()
+    /// @details Reordering adapters (Re<sup>x</sup>, Out<sup>x</sup> cut) are composed into one
+    /// index table into readBuffer(). Value changing adapters (In<sup>x</sup>) only compute the
+    /// elements in their valueMask(). The result is a single gather and blend of the two.
+    void transformFused(const std::vector<Adapter*>& adapters)
+    {
+        constexpr int channel = 0;
+        std::array<uint8_t, constants::MAX_STEPS> from{};
+        std::array<F, constants::MAX_STEPS> values{};
+        uint16_t computed = 0;
+        int length = static_cast<int>(readBuffer().size());
+        for (int i = 0; i < length; ++i) {
+            from[i] = static_cast<uint8_t>(i);
+        }
+        for (const Adapter* adapter : adapters) {
+            if (!*adapter) { continue; }
+            if (adapter->reordersIndices(length, channel)) {
+                const int outLength = adapter->queryLength(length, channel);
+                std::array<uint8_t, constants::MAX_STEPS> nextFrom{};
+                std::array<F, constants::MAX_STEPS> nextValues{};
+                uint16_t nextComputed = 0;
+                for (int i = 0; i < outLength; ++i) {
+                    const int source = adapter->querySource(i, length, channel);
+                    nextFrom[i] = from[source];
+                    nextValues[i] = values[source];
+                    if (computed & (1U << source)) { nextComputed |= 1U << i; }
+                }
+                from = nextFrom;
+                values = nextValues;
+                computed = nextComputed;
+                length = outLength;
+            }
+            const uint16_t inRange = (1U << length) - 1U;
+            for (uint16_t mask = adapter->valueMask(length, channel) & inRange; mask;
+                 mask &= mask - 1) {
+                const int i = std::countr_zero(mask);
+                const F current =
+                    (computed & (1U << i)) ? values[i] : static_cast<F>(readBuffer()[from[i]]);
+                values[i] = adapter->queryValue(i, current, channel);
+                computed |= 1U << i;
+            }
+        }
+        writeBuffer().resize(length);
+        for (int i = 0; i < length; ++i) {
+            writeBuffer()[i] =
+                (computed & (1U << i)) ? values[i] : static_cast<F>(readBuffer()[from[i]]);
+        }
+        swap();
+    }
     /// @brief Buffers for adapters to operate on
     /// @details The buffers are swapped when the operation could not take place in place.
     std::vector<F> v1, v2;
@@ -608,6 +1013,32 @@ class Expandable : public Connectable {
     {
         std::swap(voltages[0], voltages[1]);
     }
+    /// @brief Poly chain buffers: two MAX_STEPS slots per channel in one contiguous block
+    /// @details polyCurrent selects the slot holding the result of a channel, the other slot is
+    /// the scratch space for adapters that can't transform in place.
+    mutable std::vector<F> polyBuffers =
+        std::vector<F>(static_cast<size_t>(2 * constants::NUM_CHANNELS * constants::MAX_STEPS));
+    std::array<uint8_t, constants::NUM_CHANNELS> polyCurrent{};
+    std::array<int, constants::NUM_CHANNELS> polyLengths{};
+    typename std::vector<F>::iterator polySlot(int channel, int slot) const
+    {
+        return polyBuffers.begin() + (2 * channel + slot) * constants::MAX_STEPS;
+    }
+    void transformPolySlot(Adapter& adapter, int channel, int& length)
+    {
+        if (!adapter) { return; }
+        uint8_t& current = polyCurrent[channel];
+        auto first = polySlot(channel, current);
+        if (adapter.inPlace(length, channel)) {
+            adapter.transformInPlace(first, first + length, channel);
+            return;
+        }
+        auto out = polySlot(channel, !current);
+        auto newEnd = adapter.transform(first, first + length, out, channel);
+        length = static_cast<int>(std::distance(out, newEnd));
+        current = !current;
+        assert((length <= constants::MAX_STEPS) && (length >= 0));  // NOLINT
+    }
     // end Buffer&Transform section
 };
 
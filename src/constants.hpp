@@ -44,9 +44,13 @@ const extern Color PINK;
 }  // namespace colors
 namespace constants {
 
+// A buffer is as long as a polyphonic cable is wide. The adapters map its elements onto the 16
+// ports, params or channels of their expanders, so a longer buffer needs longer expanders too.
 static const int NUM_CHANNELS = 16;
 static const int MAX_GATES = 16;
 static const int MAX_STEPS = 16;
+/// @brief Stored patterns in Arr and Bank
+static const int NUM_PATTERNS = 64;
 const float UI_UPDATE_DIVIDER = 256;
 static const float BOOL_TRESHOLD = 0.5F;
 
@@ -90,6 +90,11 @@ void init(Plugin* p)
     p->addModel(modelBank);
     p->addModel(modelModX);
     p->addModel(modelGaitX);
+    p->addModel(modelBeatX);
+    p->addModel(modelLogX);
+    p->addModel(modelSortX);
+    p->addModel(modelMathX);
+    p->addModel(modelHistX);
 
     Themable::getInstance();
     // Any other plugin initialization may go here.
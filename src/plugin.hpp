@@ -22,6 +22,11 @@ extern Model* modelTie;      // NOLINT
 extern Model* modelBank;     // NOLINT
 extern Model* modelModX;     // NOLINT
 extern Model* modelGaitX;    // NOLINT
+extern Model* modelBeatX;    // NOLINT
+extern Model* modelLogX;     // NOLINT
+extern Model* modelSortX;    // NOLINT
+extern Model* modelMathX;    // NOLINT
+extern Model* modelHistX;    // NOLINT
 
 static const std::vector<std::string> themes = {
     "vapor",
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "../src/constants.hpp"
+#include "../src/plugin.hpp"
+#include "harness.hpp"
+
+namespace {
+// The ports and methods of the single Coerce as a patch stores them, its struct is in Coerce.cpp
+constexpr int SELECTIONS_INPUT = 0;
+constexpr int IN_INPUT = 1;
+constexpr int OUT_OUTPUT = 0;
+constexpr float TOLERANCE = 1e-5F;
+
+enum class RestrictMethod { RESTRICT, OCTAVE_FOLD };
+enum class RoundingMethod { CLOSEST, DOWN, UP };
+
+struct Setup {
+    harness::Row row;
+    rack::engine::Module* coerce = row.add(modelCoerce);
+
+    Setup()
+    {
+        row.patchInput(coerce, IN_INPUT, constants::NUM_CHANNELS);
+        row.patchOutput(coerce, OUT_OUTPUT);
+    }
+    void setMethods(RestrictMethod restrict, RoundingMethod rounding)
+    {
+        json_t* rootJ = json_object();
+        json_object_set_new(rootJ, "restrictMethod", json_integer(static_cast<int>(restrict)));
+        json_object_set_new(rootJ, "roundingMethod", json_integer(static_cast<int>(rounding)));
+        coerce->dataFromJson(rootJ);
+        json_decref(rootJ);
+    }
+    void setSelections(const std::vector<float>& selections)
+    {
+        row.patchInput(coerce, SELECTIONS_INPUT, static_cast<int>(selections.size()));
+        for (int c = 0; c < static_cast<int>(selections.size()); c++) {
+            coerce->inputs[SELECTIONS_INPUT].setVoltage(selections[c], c);
+        }
+    }
+    /// @brief Coerces the values, a block of 16 channels at a time
+    std::vector<float> coerceAll(const std::vector<float>& values)
+    {
+        std::vector<float> output;
+        for (size_t i = 0; i < values.size(); i += constants::NUM_CHANNELS) {
+            for (int c = 0; c < constants::NUM_CHANNELS; c++) {
+                coerce->inputs[IN_INPUT].setVoltage(values[i + c], c);
+            }
+            row.step();
+            for (int c = 0; c < constants::NUM_CHANNELS; c++) {
+                output.push_back(coerce->outputs[OUT_OUTPUT].getVoltage(c));
+            }
+        }
+        return output;
+    }
+};
+
+/// @brief Voltages from -2V to 2V in steps of 1/48V, with a little off the grid to round
+std::vector<float> inputVoltages()
+{
+    std::vector<float> values;
+    for (int i = -96; i < 96; i++) {
+        values.push_back(i / 48.F + 0.001F * static_cast<float>(i % 3));
+    }
+    return values;
+}
+/// @brief A major scale, a chord spread over octaves, a single note and a negative cluster
+const std::vector<std::vector<float>> SELECTIONS = {
+    {0.F, 2 / 12.F, 4 / 12.F, 5 / 12.F, 7 / 12.F, 9 / 12.F, 11 / 12.F},
+    {-1.F, 4 / 12.F, 1.F + 7 / 12.F},
+    {0.25F},
+    {-0.5F, -0.45F, -0.4F, -0.35F}};
+constexpr std::array<RestrictMethod, 2> RESTRICT_METHODS = {RestrictMethod::RESTRICT,
+                                                            RestrictMethod::OCTAVE_FOLD};
+constexpr std::array<RoundingMethod, 3> ROUNDING_METHODS = {
+    RoundingMethod::CLOSEST, RoundingMethod::DOWN, RoundingMethod::UP};
+constexpr std::array<const char*, 3> ROUNDING_NAMES = {"closest", "down", "up"};
+
+float fraction(float voltage)
+{
+    return voltage - std::floor(voltage);
+}
+/// @brief The distance of two voltages within an octave, 0 to 0.5
+float octaveDistance(float a, float b)
+{
+    const float distance = std::abs(fraction(a) - fraction(b));
+    return std::min(distance, 1.F - distance);
+}
+}  // namespace
+
+TEST(coerceMatchesGolden)
+{
+    Setup setup;
+    harness::Golden golden("coerce");
+    const std::vector<float> input = inputVoltages();
+    for (const auto restrict : RESTRICT_METHODS) {
+        for (const auto rounding : ROUNDING_METHODS) {
+            setup.setMethods(restrict, rounding);
+            for (size_t s = 0; s < SELECTIONS.size(); s++) {
+                setup.setSelections(SELECTIONS[s]);
+                const std::vector<float> output = setup.coerceAll(input);
+                for (size_t i = 0; i < input.size(); i++) {
+                    golden.add(std::string(restrict == RestrictMethod::RESTRICT ? "restrict"
+                                                                                : "fold") +
+                                   "/" + ROUNDING_NAMES[static_cast<int>(rounding)] +
+                                   "/selections" + std::to_string(s) + "/" + std::to_string(i),
+                               output[i]);
+                }
+            }
+        }
+    }
+    CHECK(golden.matches());
+}
+
+TEST(coerceRestrictsToTheSelections)
+{
+    Setup setup;
+    const std::vector<float> input = inputVoltages();
+    for (const auto rounding : ROUNDING_METHODS) {
+        setup.setMethods(RestrictMethod::RESTRICT, rounding);
+        for (const std::vector<float>& selections : SELECTIONS) {
+            setup.setSelections(selections);
+            const std::vector<float> output = setup.coerceAll(input);
+            const auto [lowest, highest] =
+                std::minmax_element(selections.begin(), selections.end());
+            for (size_t i = 0; i < input.size(); i++) {
+                CHECK(std::find(selections.begin(), selections.end(), output[i]) !=
+                      selections.end());
+                for (const float selection : selections) {
+                    const float distance = std::abs(selection - input[i]);
+                    switch (rounding) {
+                        case RoundingMethod::CLOSEST:
+                            CHECK(std::abs(output[i] - input[i]) <= distance);
+                            break;
+                        // Nothing below or above the value: the lowest or highest selection
+                        case RoundingMethod::DOWN:
+                            CHECK(input[i] < *lowest ? output[i] == *lowest
+                                                     : output[i] <= input[i] &&
+                                                           (selection > input[i] ||
+                                                            input[i] - output[i] <= distance));
+                            break;
+                        case RoundingMethod::UP:
+                            CHECK(input[i] > *highest ? output[i] == *highest
+                                                      : output[i] >= input[i] &&
+                                                            (selection < input[i] ||
+                                                             output[i] - input[i] <= distance));
+                            break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(coerceFoldsTheSelectionsIntoEveryOctave)
+{
+    Setup setup;
+    const std::vector<float> input = inputVoltages();
+    for (const auto rounding : ROUNDING_METHODS) {
+        setup.setMethods(RestrictMethod::OCTAVE_FOLD, rounding);
+        for (const std::vector<float>& selections : SELECTIONS) {
+            setup.setSelections(selections);
+            const std::vector<float> output = setup.coerceAll(input);
+            for (size_t i = 0; i < input.size(); i++) {
+                // The output is a selection moved by whole octaves
+                CHECK(std::any_of(selections.begin(), selections.end(), [&](float selection) {
+                    return octaveDistance(output[i], selection) < TOLERANCE;
+                }));
+                switch (rounding) {
+                    // Closest is at least as close as every selection in the octave of the
+                    // value, one in the octave next to it is not always taken when closer
+                    case RoundingMethod::CLOSEST:
+                        for (const float selection : selections) {
+                            const float sameOctave = std::floor(input[i]) + fraction(selection);
+                            CHECK(std::abs(output[i] - input[i]) <=
+                                  std::abs(sameOctave - input[i]) + TOLERANCE);
+                        }
+                        CHECK(std::abs(output[i] - input[i]) < 1.F);
+                        break;
+                    case RoundingMethod::DOWN:
+                        CHECK(output[i] <= input[i] + TOLERANCE && output[i] > input[i] - 1.F);
+                        break;
+                    case RoundingMethod::UP:
+                        CHECK(output[i] >= input[i] - TOLERANCE && output[i] < input[i] + 1.F);
+                        break;
+                }
+            }
+        }
+    }
+}
+
+TEST(coercePassesThroughWithoutSelections)
+{
+    Setup setup;
+    const std::vector<float> input = inputVoltages();
+    for (const auto restrict : RESTRICT_METHODS) {
+        setup.setMethods(restrict, RoundingMethod::CLOSEST);
+        CHECK(setup.coerceAll(input) == input);
+    }
+}
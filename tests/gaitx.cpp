@@ -0,0 +1,69 @@
+#include <array>
+#include <string>
+#include "../src/GaitX.hpp"
+#include "../src/plugin.hpp"
+#include "harness.hpp"
+
+namespace {
+/// @brief A GaitX with its step output scaled in mode, as a patch loads it
+GaitX* addGaitX(harness::Row& row, GaitX::StepOutputVoltageMode mode)
+{
+    auto* gaitx = row.add<GaitX>(modelGaitX);
+    json_t* rootJ = json_object();
+    json_object_set_new(rootJ, "stepOutputVoltageMode", json_integer(mode));
+    gaitx->dataFromJson(rootJ);
+    json_decref(rootJ);
+    return gaitx;
+}
+float stepVoltage(GaitXAdapter& adapter, GaitX* gaitx, int step, int totalSteps)
+{
+    adapter.setStep(step, totalSteps);
+    return gaitx->outputs[GaitX::OUTPUT_STEP].getVoltage();
+}
+
+constexpr std::array<GaitX::StepOutputVoltageMode, 3> MODES = {
+    GaitX::SCALE_10V_TO_16STEPS, GaitX::SCALE_10_TO_LENGTH_PLUS, GaitX::SCALE_10_TO_LENGTH};
+}  // namespace
+
+TEST(gaitxStepVoltagesMatchGolden)
+{
+    harness::Golden golden("gaitx_steps");
+    for (const auto mode : MODES) {
+        harness::Row row;
+        GaitX* gaitx = addGaitX(row, mode);
+        GaitXAdapter adapter;
+        adapter.setPtr(gaitx);
+        for (int total = 1; total <= constants::MAX_STEPS; total++) {
+            for (int step = 0; step < total; step++) {
+                golden.add("mode" + std::to_string(mode) + "/total" + std::to_string(total) +
+                               "/step" + std::to_string(step),
+                           stepVoltage(adapter, gaitx, step, total));
+            }
+        }
+    }
+    CHECK(golden.matches());
+}
+
+TEST(gaitxStepVoltagesRiseFromZeroToTen)
+{
+    for (const auto mode : MODES) {
+        harness::Row row;
+        GaitX* gaitx = addGaitX(row, mode);
+        GaitXAdapter adapter;
+        adapter.setPtr(gaitx);
+        // A single step has nothing to rise over, 10 to length plus divides by 0 for it
+        for (int total = 2; total <= constants::MAX_STEPS; total++) {
+            CHECK(stepVoltage(adapter, gaitx, 0, total) == 0.F);
+            for (int step = 1; step < total; step++) {
+                CHECK(stepVoltage(adapter, gaitx, step, total) >
+                      stepVoltage(adapter, gaitx, step - 1, total));
+            }
+            const float last = stepVoltage(adapter, gaitx, total - 1, total);
+            switch (mode) {
+                case GaitX::SCALE_10V_TO_16STEPS: CHECK(last == 0.625F * (total - 1)); break;
+                case GaitX::SCALE_10_TO_LENGTH_PLUS: CHECK(last == 10.F); break;
+                case GaitX::SCALE_10_TO_LENGTH: CHECK(last < 10.F); break;
+            }
+        }
+    }
+}
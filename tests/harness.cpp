@@ -0,0 +1,202 @@
+#include "harness.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace harness {
+namespace {
+int failures = 0;
+}  // namespace
+
+Context::Context(float sampleRate) : context(new rack::Context)
+{
+    rack::contextSet(context);
+    context->engine = new rack::engine::Engine;
+    context->engine->setSampleRate(sampleRate);
+}
+
+Context::~Context()
+{
+    // Deletes the engine too
+    delete context;
+    rack::contextSet(nullptr);
+}
+
+std::vector<Test>& tests()
+{
+    static std::vector<Test> registered;
+    return registered;
+}
+
+void check(bool passed, const char* expression, const char* file, int line)
+{
+    if (passed) { return; }
+    ++failures;
+    std::printf("%s:%d: CHECK(%s) failed\n", file, line, expression);
+}
+
+int runTests()
+{
+    for (const Test& test : tests()) {
+        const int failuresBefore = failures;
+        test.run();
+        std::printf("%s %s\n", failures == failuresBefore ? "ok  " : "FAIL", test.name);
+    }
+    std::printf("%zu tests, %d failed checks\n", tests().size(), failures);
+    return failures;
+}
+
+void Golden::add(const std::string& key, float value)
+{
+    values.emplace_back(key, value);
+}
+
+bool Golden::matches() const
+{
+    const std::string path = "tests/golden/" + name + ".txt";
+    const char* update = std::getenv("SIM_UPDATE_GOLDEN");
+    if (update && std::strcmp(update, "1") == 0) {
+        std::FILE* file = std::fopen(path.c_str(), "w");
+        if (!file) { return false; }
+        for (const auto& [key, value] : values) {
+            std::fprintf(file, "%s %.9g\n", key.c_str(), value);
+        }
+        return std::fclose(file) == 0;
+    }
+    std::FILE* file = std::fopen(path.c_str(), "r");
+    if (!file) {
+        std::printf("%s: missing, run the tests with SIM_UPDATE_GOLDEN=1\n", path.c_str());
+        return false;
+    }
+    int differences = 0;
+    size_t line = 0;
+    char key[256];
+    float expected = 0.F;
+    while (std::fscanf(file, "%255s %f", key, &expected) == 2) {
+        const bool same =
+            line < values.size() && values[line].first == key &&
+            (values[line].second == expected ||
+             (std::isnan(values[line].second) && std::isnan(expected)));
+        if (!same && ++differences <= 5) {
+            std::printf("%s:%zu: %s %.9g, got ", path.c_str(), line + 1, key, expected);
+            if (line < values.size()) {
+                std::printf("%s %.9g\n", values[line].first.c_str(), values[line].second);
+            }
+            else {
+                std::printf("nothing\n");
+            }
+        }
+        ++line;
+    }
+    std::fclose(file);
+    if (line != values.size()) {
+        std::printf("%s: %zu values, got %zu\n", path.c_str(), line, values.size());
+        return false;
+    }
+    return differences == 0;
+}
+
+Row::~Row()
+{
+    while (!modules.empty()) {
+        remove(modules.back());
+    }
+}
+
+rack::engine::Module* Row::add(rack::engine::Module* module)
+{
+    module->id = nextId++;
+    modules.push_back(module);
+    placeModules();
+    module->onAdd(rack::engine::Module::AddEvent{});
+    const float sampleRate = APP->engine->getSampleRate();
+    module->onSampleRateChange(
+        rack::engine::Module::SampleRateChangeEvent{sampleRate, 1.F / sampleRate});
+    return module;
+}
+
+void Row::remove(rack::engine::Module* module)
+{
+    module->onRemove(rack::engine::Module::RemoveEvent{});
+    for (rack::engine::Module* other : modules) {
+        for (auto* expander : {&other->leftExpander, &other->rightExpander}) {
+            if (expander->module != module) { continue; }
+            expander->moduleId = -1;
+            expander->module = nullptr;
+        }
+    }
+    modules.erase(std::find(modules.begin(), modules.end(), module));
+    delete module;
+    placeModules();
+}
+
+void Row::patchInput(rack::engine::Module* module, int inputId, int channels)
+{
+    // Rack keeps unpatched ports at 0 channels, setChannels() can't change that
+    module->inputs[inputId].channels = channels;
+    module->onPortChange(rack::engine::Module::PortChangeEvent{
+        channels > 0, rack::engine::Port::INPUT, inputId});
+}
+
+void Row::patchOutput(rack::engine::Module* module, int outputId, bool patched)
+{
+    module->outputs[outputId].channels = patched ? 1 : 0;
+    module->onPortChange(
+        rack::engine::Module::PortChangeEvent{patched, rack::engine::Port::OUTPUT, outputId});
+}
+
+void Row::setParam(rack::engine::Module* module, int paramId, float value)
+{
+    module->getParamQuantity(paramId)->setValue(value);
+}
+
+void Row::step(int frames)
+{
+    const float sampleRate = APP->engine->getSampleRate();
+    for (int i = 0; i < frames; ++i) {
+        for (rack::engine::Module* module : modules) {
+            updateExpander(module, 0);
+            updateExpander(module, 1);
+        }
+        const rack::engine::Module::ProcessArgs args{sampleRate, 1.F / sampleRate, frame++};
+        for (rack::engine::Module* module : modules) {
+            module->process(args);
+        }
+    }
+}
+
+void Row::placeModules()
+{
+    for (size_t i = 0; i < modules.size(); ++i) {
+        modules[i]->leftExpander.moduleId = i > 0 ? modules[i - 1]->id : -1;
+        modules[i]->rightExpander.moduleId = i + 1 < modules.size() ? modules[i + 1]->id : -1;
+    }
+}
+
+/// @brief Engine_updateExpander_NoLock() of Rack's engine
+void Row::updateExpander(rack::engine::Module* module, uint8_t side)
+{
+    rack::engine::Module::Expander& expander = side ? module->rightExpander : module->leftExpander;
+    rack::engine::Module* previous = expander.module;
+    if (expander.moduleId >= 0) {
+        if (!expander.module || expander.module->id != expander.moduleId) {
+            expander.module = getModule(expander.moduleId);
+        }
+    }
+    else {
+        expander.module = nullptr;
+    }
+    if (expander.module != previous) {
+        module->onExpanderChange(rack::engine::Module::ExpanderChangeEvent{side});
+    }
+}
+
+rack::engine::Module* Row::getModule(int64_t moduleId) const
+{
+    auto it = std::find_if(modules.begin(), modules.end(),
+                           [moduleId](const auto* module) { return module->id == moduleId; });
+    return it == modules.end() ? nullptr : *it;
+}
+}  // namespace harness
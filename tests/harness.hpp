@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <rack.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// @brief Runs SIM modules without Rack's window, audio device or engine thread
+/// @details Tests and tools/sim_render.cpp place modules in a Row, patch cables into them and
+/// step the row. The row sends the events Rack's engine sends, so chains of expanders resolve as
+/// they do in a patch.
+namespace harness {
+/// @brief Rack's context with just an engine, the modules only read the sample rate from it
+class Context {
+   public:
+    explicit Context(float sampleRate = 48000.F);
+    ~Context();
+    Context(const Context&) = delete;
+    Context& operator=(const Context&) = delete;
+
+   private:
+    rack::Context* context;
+};
+
+/// @brief A test case, defined with TEST()
+struct Test {
+    const char* name;
+    void (*run)();
+};
+std::vector<Test>& tests();
+struct Registration {
+    Registration(const char* name, void (*run)())
+    {
+        tests().push_back({name, run});
+    }
+};
+/// @brief Reports a failed check, the test goes on
+void check(bool passed, const char* expression, const char* file, int line);
+/// @brief Runs every test, returns the number of failed checks
+int runTests();
+
+/// @brief Values a test compares with tests/golden/<name>.txt, a "key value" line for each
+/// @details With SIM_UPDATE_GOLDEN=1 in the environment the file is written instead. Do that only
+/// for a change of the output that is meant, and review the diff of the file.
+class Golden {
+   public:
+    explicit Golden(std::string name) : name(std::move(name)) {}
+    void add(const std::string& key, float value);
+    /// @brief Compares the values with the file, the first differences go to stdout
+    bool matches() const;
+
+   private:
+    std::string name;
+    std::vector<std::pair<std::string, float>> values;
+};
+
+/// @brief Modules side by side in a row of the rack, stepped like Rack's engine steps them
+/// @details Neighbours are recorded by module id, as the rack widget does. Expander pointers are
+/// resolved at the start of the next step(), sending onExpanderChange() before any module is
+/// processed, as Engine::stepBlock() does. Removing a module sends onRemove() and clears the
+/// pointers to it without an expander change, like Engine::removeModule().
+class Row {
+   public:
+    Row() = default;
+    ~Row();
+    Row(const Row&) = delete;
+    Row& operator=(const Row&) = delete;
+
+    /// @brief Adds a module of model at the right end of the row
+    template <typename TModule = rack::engine::Module>
+    TModule* add(rack::plugin::Model* model)
+    {
+        return static_cast<TModule*>(add(model->createModule()));
+    }
+    rack::engine::Module* add(rack::engine::Module* module);
+    /// @brief Removes module and deletes it, its neighbours move together
+    void remove(rack::engine::Module* module);
+    /// @brief Patches a cable with channels into an input, 0 channels unpatches it
+    void patchInput(rack::engine::Module* module, int inputId, int channels = 1);
+    /// @brief Patches a cable into an output or unpatches it
+    void patchOutput(rack::engine::Module* module, int outputId, bool patched = true);
+    /// @brief Turns a knob as the UI does, through the ParamQuantity of the param
+    /// @details Setting Module::params directly skips the change notification of the SIM
+    /// modules, they then see the change when they poll their params.
+    static void setParam(rack::engine::Module* module, int paramId, float value);
+    /// @brief Runs frames samples of every module, from left to right
+    void step(int frames = 1);
+
+   private:
+    std::vector<rack::engine::Module*> modules;
+    int64_t nextId = 1;
+    int64_t frame = 0;
+    /// @brief Records the neighbours of every module, the pointers follow in step()
+    void placeModules();
+    void updateExpander(rack::engine::Module* module, uint8_t side);
+    rack::engine::Module* getModule(int64_t moduleId) const;
+};
+}  // namespace harness
+
+#define TEST(name)                                                           \
+    static void name();                                                      \
+    static const harness::Registration name##Registration(#name, &(name)); \
+    static void name()
+#define CHECK(expression) harness::check((expression), #expression, __FILE__, __LINE__)
@@ -0,0 +1,74 @@
+#include <vector>
+#include "../src/HistX.hpp"
+#include "../src/plugin.hpp"
+#include "harness.hpp"
+
+namespace {
+struct Setup {
+    harness::Row row;
+    HistX* histx = row.add<HistX>(modelHistX);
+    HistxAdapter adapter;
+    int round = 0;
+
+    Setup()
+    {
+        adapter.setPtr(histx);
+        row.patchInput(histx, HistX::INPUT_STEP);
+        // The trigger needs a low before it sees the first step
+        row.step();
+    }
+    /// @brief Sends the buffer {round} through the adapter, then steps the history
+    float next()
+    {
+        std::vector<float> buffer{static_cast<float>(round++)};
+        adapter.transformInPlace(buffer.begin(), buffer.end(), 0);
+        histx->inputs[HistX::INPUT_STEP].setVoltage(10.F);
+        row.step();
+        histx->inputs[HistX::INPUT_STEP].setVoltage(0.F);
+        row.step();
+        return buffer[0];
+    }
+};
+}  // namespace
+
+TEST(histxReachesBackOverTheWholeHistory)
+{
+    for (const int tap : {1, 8, 15, 16}) {
+        Setup setup;
+        harness::Row::setParam(setup.histx, HistX::PARAM_TAP, static_cast<float>(tap));
+        for (int round = 0; round < 40; round++) {
+            const float output = setup.next();
+            // Until the history reaches back far enough the buffer passes
+            CHECK(output == static_cast<float>(round < tap ? round : round - tap));
+        }
+    }
+}
+
+TEST(histxTapCvReachesTheOldestSnapshot)
+{
+    Setup setup;
+    setup.row.patchInput(setup.histx, HistX::INPUT_TAP);
+    setup.histx->inputs[HistX::INPUT_TAP].setVoltage(10.F);
+    for (int round = 0; round < 20; round++) {
+        setup.next();
+    }
+    CHECK(setup.next() == 20.F - 16.F);
+    setup.histx->inputs[HistX::INPUT_TAP].setVoltage(0.F);
+    CHECK(setup.next() == 21.F);
+}
+
+TEST(histxLoopsTheLastTapSnapshots)
+{
+    for (const int tap : {1, 5, 16}) {
+        Setup setup;
+        harness::Row::setParam(setup.histx, HistX::PARAM_TAP, static_cast<float>(tap));
+        for (int round = 0; round < 20; round++) {
+            setup.next();
+        }
+        harness::Row::setParam(setup.histx, HistX::PARAM_LOOP, 1.F);
+        // The step after round 19 already loops, the snapshots of rounds 19 - tap to 18 repeat
+        for (int round = 20; round < 60; round++) {
+            CHECK(setup.next() == static_cast<float>(19 - tap + (round - 19) % tap));
+        }
+    }
+}
@@ -0,0 +1,196 @@
+#include <random>
+#include <type_traits>
+#include <vector>
+#include "../src/InX.hpp"
+#include "../src/plugin.hpp"
+#include "harness.hpp"
+
+namespace {
+constexpr float GATE_ON = 1.F;
+
+/// @brief The ports of an In^x: a patched cable per port with its channels, 0 for none
+struct Patch {
+    std::vector<int> channels = std::vector<int>(constants::NUM_CHANNELS);
+
+    void apply(harness::Row& row, InX* inx) const
+    {
+        for (int port = 0; port < constants::NUM_CHANNELS; port++) {
+            row.patchInput(inx, InX::INPUT_SIGNAL + port, channels[port]);
+            for (int c = 0; c < channels[port]; c++) {
+                inx->inputs[InX::INPUT_SIGNAL + port].setVoltage(voltage(port, c), c);
+            }
+        }
+    }
+    /// @brief Every third value is below the gate threshold
+    static float voltage(int port, int channel)
+    {
+        return ((port + channel) % 3 == 0) ? 0.5F : 10.F + port + channel * 0.125F;
+    }
+};
+
+/// @brief In^x overwrite and add/and: the port at the index of an element replaces or adds to it
+template <typename T>
+std::vector<T> referenceInPlace(const Patch& patch,
+                                InX::InsertMode mode,
+                                std::vector<T> input,
+                                int channel)
+{
+    for (int i = 0; i < static_cast<int>(input.size()) && i < constants::NUM_CHANNELS; i++) {
+        if (!patch.channels[i]) { continue; }
+        const float voltage = Patch::voltage(i, channel);
+        if constexpr (std::is_same_v<T, bool>) {
+            const bool gate = voltage > GATE_ON;
+            input[i] = mode == InX::InsertMode::ADD_AND ? gate && input[i] : gate;
+        }
+        else {
+            input[i] = voltage + (mode == InX::InsertMode::ADD_AND ? input[i] : 0.F);
+        }
+    }
+    return input;
+}
+/// @brief In^x insert: all channels of a patched port go before the element at its index
+template <typename T>
+std::vector<T> referenceInsert(const Patch& patch, const std::vector<T>& input)
+{
+    std::vector<T> output;
+    auto next = input.begin();
+    int lastPatched = -1;
+    for (int port = 0; port < constants::NUM_CHANNELS; port++) {
+        if (patch.channels[port]) { lastPatched = port; }
+    }
+    for (int port = 0; port <= lastPatched; port++) {
+        for (int c = 0; c < patch.channels[port]; c++) {
+            if constexpr (std::is_same_v<T, bool>) {
+                output.push_back(Patch::voltage(port, c) > GATE_ON);
+            }
+            else {
+                output.push_back(Patch::voltage(port, c));
+            }
+        }
+        if (next != input.end()) { output.push_back(*next++); }
+    }
+    output.insert(output.end(), next, input.end());
+    if (output.size() > constants::NUM_CHANNELS) { output.resize(constants::NUM_CHANNELS); }
+    return output;
+}
+
+template <typename T>
+std::vector<T> transform(const InxAdapter& adapter, std::vector<T> input, int channel = 0)
+{
+    const int size = static_cast<int>(input.size());
+    if (adapter.inPlace(size, channel)) {
+        adapter.transformInPlace(input.begin(), input.end(), channel);
+        return input;
+    }
+    std::vector<T> output(constants::MAX_GATES);
+    output.erase(adapter.transform(input.begin(), input.end(), output.begin(), channel),
+                 output.end());
+    return output;
+}
+
+std::vector<float> voltages(int size)
+{
+    std::vector<float> input;
+    for (int i = 0; i < size; i++) {
+        input.push_back(-static_cast<float>(i) - 0.5F);
+    }
+    return input;
+}
+std::vector<bool> gates(int size)
+{
+    std::vector<bool> input;
+    for (int i = 0; i < size; i++) {
+        input.push_back(i % 4 != 1);
+    }
+    return input;
+}
+
+/// @brief Patches with mostly mono cables, a few poly ones and sometimes none at all
+Patch randomPatch(std::mt19937& random)
+{
+    Patch patch;
+    for (int& channels : patch.channels) {
+        const unsigned dice = random() % 8;
+        channels = dice < 5 ? 0 : dice < 7 ? 1 : 1 + static_cast<int>(random() % 4);
+    }
+    return patch;
+}
+}  // namespace
+
+TEST(inxModes)
+{
+    std::mt19937 random(26);
+    for (int round = 0; round < 200; round++) {
+        harness::Row row;
+        auto* inx = row.add<InX>(modelInX);
+        InxAdapter adapter;
+        adapter.setPtr(inx);
+        const Patch patch = randomPatch(random);
+        patch.apply(row, inx);
+        for (const auto mode :
+             {InX::InsertMode::OVERWRITE, InX::InsertMode::INSERT, InX::InsertMode::ADD_AND}) {
+            harness::Row::setParam(inx, InX::PARAM_INSERTMODE, static_cast<float>(mode));
+            CHECK(adapter.inPlace(constants::MAX_GATES, 0) == (mode != InX::InsertMode::INSERT));
+            for (int size = 0; size <= constants::MAX_GATES; size++) {
+                if (mode == InX::InsertMode::INSERT) {
+                    CHECK(transform(adapter, voltages(size)) ==
+                          referenceInsert(patch, voltages(size)));
+                    CHECK(transform(adapter, gates(size)) == referenceInsert(patch, gates(size)));
+                    continue;
+                }
+                CHECK(transform(adapter, voltages(size)) ==
+                      referenceInPlace(patch, mode, voltages(size), 0));
+                CHECK(transform(adapter, gates(size)) ==
+                      referenceInPlace(patch, mode, gates(size), 0));
+            }
+        }
+    }
+}
+
+TEST(inxOverwritesWithTheChannelOfTheChain)
+{
+    harness::Row row;
+    auto* inx = row.add<InX>(modelInX);
+    InxAdapter adapter;
+    adapter.setPtr(inx);
+    Patch patch;
+    patch.channels[2] = 4;
+    patch.channels[5] = 4;
+    patch.apply(row, inx);
+    for (const auto mode : {InX::InsertMode::OVERWRITE, InX::InsertMode::ADD_AND}) {
+        harness::Row::setParam(inx, InX::PARAM_INSERTMODE, static_cast<float>(mode));
+        for (int channel = 0; channel < 4; channel++) {
+            CHECK(transform(adapter, voltages(8), channel) ==
+                  referenceInPlace(patch, mode, voltages(8), channel));
+        }
+    }
+}
+
+TEST(inxAnswersQueriesLikeItTransforms)
+{
+    std::mt19937 random(27);
+    for (int round = 0; round < 200; round++) {
+        harness::Row row;
+        auto* inx = row.add<InX>(modelInX);
+        InxAdapter adapter;
+        adapter.setPtr(inx);
+        randomPatch(random).apply(row, inx);
+        for (const auto mode : {InX::InsertMode::OVERWRITE, InX::InsertMode::ADD_AND}) {
+            harness::Row::setParam(inx, InX::PARAM_INSERTMODE, static_cast<float>(mode));
+            CHECK(adapter.canQuery());
+            for (int size = 0; size <= constants::MAX_GATES; size++) {
+                const std::vector<float> input = voltages(size);
+                const std::vector<float> output = transform(adapter, input);
+                const uint16_t changing = adapter.valueMask(size, 0);
+                for (int i = 0; i < size; i++) {
+                    const float queried =
+                        (changing & (1U << i)) ? adapter.queryValue(i, input[i], 0) : input[i];
+                    CHECK(queried == output[i]);
+                }
+            }
+        }
+        harness::Row::setParam(inx, InX::PARAM_INSERTMODE,
+                               static_cast<float>(InX::InsertMode::INSERT));
+        CHECK(!adapter.canQuery());
+    }
+}
@@ -0,0 +1,63 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include "../src/PatternLibrary.hpp"
+#include "../src/plugin.hpp"
+#include "harness.hpp"
+
+namespace {
+constexpr int ARR_INPUT_PATTERN = 0;
+constexpr int ARR_OUTPUT_MAIN = 0;
+
+/// @brief Writes csv to a file and converts it into the voltage library at path
+bool writeLibrary(const std::string& path, const std::string& csv)
+{
+    const std::string csvPath = path + ".csv";
+    std::ofstream(csvPath) << csv;
+    const std::string error = patlib::convert(csvPath, path, patlib::Type::VOLTAGES);
+    std::remove(csvPath.c_str());
+    return error.empty();
+}
+bool outputIs(rack::engine::Module* arr, const std::vector<float>& voltages)
+{
+    rack::engine::Output& output = arr->outputs[ARR_OUTPUT_MAIN];
+    if (output.getChannels() != static_cast<int>(voltages.size())) { return false; }
+    for (int c = 0; c < output.getChannels(); c++) {
+        if (output.getVoltage(c) != voltages[c]) { return false; }
+    }
+    return true;
+}
+}  // namespace
+
+TEST(arrFollowsTheFileOfItsLibrary)
+{
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "sim_library_test.simlib").string();
+    CHECK(writeLibrary(path, "1,2,3\n4,5\n"));
+    harness::Row row;
+    rack::engine::Module* arr = row.add(modelArr);
+    row.patchOutput(arr, ARR_OUTPUT_MAIN);
+    json_t* rootJ = json_object();
+    json_object_set_new(rootJ, "library", json_string(path.c_str()));
+    arr->dataFromJson(rootJ);
+    json_decref(rootJ);
+    row.step();
+    CHECK(outputIs(arr, {1.F, 2.F, 3.F}));
+    row.patchInput(arr, ARR_INPUT_PATTERN);
+    arr->inputs[ARR_INPUT_PATTERN].setVoltage(10.F);
+    row.step();
+    CHECK(outputIs(arr, {4.F, 5.F}));
+
+    // The watcher remaps a changed file without a UI, within about a second
+    CHECK(writeLibrary(path, "6\n7,8\n9\n"));
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!outputIs(arr, {9.F}) && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        row.step();
+    }
+    CHECK(outputIs(arr, {9.F}));
+    std::remove(path.c_str());
+}
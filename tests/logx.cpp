@@ -0,0 +1,29 @@
+#include "../src/LogX.hpp"
+#include "../src/OutX.hpp"
+#include "../src/plugin.hpp"
+#include "harness.hpp"
+
+namespace {
+constexpr int BANK_PARAM_BOOL = 0;
+}  // namespace
+
+TEST(logxFindsTheBankToItsLeft)
+{
+    harness::Row row;
+    rack::engine::Module* source = row.add(modelBank);
+    rack::engine::Module* coerce = row.add(modelCoerce);
+    row.add(modelOutX);
+    auto* logx = row.add<LogX>(modelLogX);
+    row.add(modelBank);
+    harness::Row::setParam(source, BANK_PARAM_BOOL + 2, 1.F);
+    row.step();
+    // A module without chain events ends the walk, its neighbours could change unseen
+    CHECK(logx->getSourceGates() == 0);
+
+    // Across the Out^x of the source
+    row.remove(coerce);
+    row.step();
+    CHECK(logx->getSourceGates() == logx::bankGates(*source));
+    CHECK(logx::length(logx->getSourceGates()) == constants::MAX_STEPS);
+    CHECK((logx->getSourceGates() & 0xFFFFU) == 1U << 2U);
+}
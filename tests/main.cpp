@@ -0,0 +1,7 @@
+#include "harness.hpp"
+
+int main()
+{
+    const harness::Context context;
+    return harness::runTests() == 0 ? 0 : 1;
+}
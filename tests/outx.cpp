@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <vector>
+#include "../src/OutX.hpp"
+#include "../src/plugin.hpp"
+#include "harness.hpp"
+
+namespace {
+bool isPatched(uint16_t patched, int port)
+{
+    return (patched & (1U << port)) != 0;
+}
+int lastPatched(uint16_t patched)
+{
+    int last = -1;
+    for (int port = 0; port < constants::NUM_CHANNELS; port++) {
+        if (isPatched(patched, port)) { last = port; }
+    }
+    return last;
+}
+
+/// @brief Out^x cut of voltages: individual drops the elements at patched ports, normalled drops
+/// every element up to the last patched port
+std::vector<float> referenceCut(uint16_t patched, bool normalled, const std::vector<float>& input)
+{
+    std::vector<float> output;
+    for (int i = 0; i < static_cast<int>(input.size()); i++) {
+        const bool cut = normalled ? i <= lastPatched(patched) : isPatched(patched, i);
+        if (!cut) { output.push_back(input[i]); }
+    }
+    return output;
+}
+/// @brief Out^x cut of gates: the same elements are turned off, the length stays
+std::vector<bool> referenceCut(uint16_t patched, bool normalled, std::vector<bool> input)
+{
+    for (int i = 0; i < static_cast<int>(input.size()); i++) {
+        if (normalled ? i <= lastPatched(patched) : isPatched(patched, i)) { input[i] = false; }
+    }
+    return input;
+}
+
+template <typename T>
+std::vector<T> transform(const OutxAdapter& adapter, std::vector<T> input)
+{
+    const int size = static_cast<int>(input.size());
+    if (adapter.inPlace(size, 0)) {
+        adapter.transformInPlace(input.begin(), input.end(), 0);
+        return input;
+    }
+    std::vector<T> output(constants::MAX_GATES);
+    output.erase(adapter.transform(input.begin(), input.end(), output.begin(), 0), output.end());
+    return output;
+}
+
+std::vector<float> voltages(int size)
+{
+    std::vector<float> input;
+    for (int i = 0; i < size; i++) {
+        input.push_back(static_cast<float>(i) + 1.F);
+    }
+    return input;
+}
+std::vector<bool> gates(int size)
+{
+    return std::vector<bool>(size, true);
+}
+
+struct Setup {
+    harness::Row row;
+    OutX* outx = row.add<OutX>(modelOutX);
+    OutxAdapter adapter;
+
+    Setup()
+    {
+        adapter.setPtr(outx);
+    }
+    void patch(uint16_t patched)
+    {
+        for (int port = 0; port < constants::NUM_CHANNELS; port++) {
+            row.patchOutput(outx, OutX::OUTPUT_SIGNAL + port, isPatched(patched, port));
+        }
+    }
+    void setModes(bool normalled, bool cut)
+    {
+        harness::Row::setParam(outx, OutX::PARAM_NORMALLED, normalled ? 1.F : 0.F);
+        harness::Row::setParam(outx, OutX::PARAM_CUT, cut ? 1.F : 0.F);
+    }
+};
+/// @brief 256 of the 65536 ways to patch the ports, including none and all of them
+constexpr uint16_t PATCH_STEP = 257;
+}  // namespace
+
+TEST(outxCopiesWithoutCut)
+{
+    Setup setup;
+    for (uint32_t patched = 0; patched <= 0xFFFFU; patched += PATCH_STEP) {
+        setup.patch(patched);
+        for (const bool normalled : {false, true}) {
+            setup.setModes(normalled, false);
+            for (int size = 0; size <= constants::MAX_GATES; size++) {
+                CHECK(setup.adapter.inPlace(size, 0));
+                CHECK(transform(setup.adapter, voltages(size)) == voltages(size));
+                CHECK(transform(setup.adapter, gates(size)) == gates(size));
+            }
+        }
+    }
+}
+
+TEST(outxCutsIndividualAndNormalled)
+{
+    Setup setup;
+    for (uint32_t patched = 0; patched <= 0xFFFFU; patched += PATCH_STEP) {
+        setup.patch(patched);
+        for (const bool normalled : {false, true}) {
+            setup.setModes(normalled, true);
+            for (int size = 0; size <= constants::MAX_GATES; size++) {
+                CHECK(transform(setup.adapter, voltages(size)) ==
+                      referenceCut(patched, normalled, voltages(size)));
+                CHECK(transform(setup.adapter, gates(size)) ==
+                      referenceCut(patched, normalled, gates(size)));
+                // The fused chain and Arr's partial updates use the queries
+                const std::vector<float> output = transform(setup.adapter, voltages(size));
+                CHECK(setup.adapter.queryLength(size, 0) == static_cast<int>(output.size()));
+                for (int i = 0; i < static_cast<int>(output.size()); i++) {
+                    CHECK(voltages(size)[setup.adapter.querySource(i, size, 0)] == output[i]);
+                }
+            }
+        }
+    }
+}
+
+TEST(outxWritesIndividualPorts)
+{
+    Setup setup;
+    setup.setModes(false, false);
+    for (uint32_t patched = 0; patched <= 0xFFFFU; patched += PATCH_STEP) {
+        setup.patch(patched);
+        for (int size = 0; size <= constants::MAX_GATES; size++) {
+            const std::vector<float> input = voltages(size);
+            setup.adapter.write(input.begin(), input.end());
+            for (int port = 0; port < size; port++) {
+                if (!isPatched(patched, port)) { continue; }
+                CHECK(setup.outx->outputs[port].getChannels() == 1);
+                CHECK(setup.outx->outputs[port].getVoltage() == input[port]);
+            }
+            for (int port = size; port < constants::NUM_CHANNELS; port++) {
+                CHECK(setup.outx->outputs[port].getVoltage() == 0.F);
+            }
+        }
+    }
+}
+
+TEST(outxWritesNormalledPorts)
+{
+    Setup setup;
+    setup.setModes(true, false);
+    for (uint32_t patched = 0; patched <= 0xFFFFU; patched += PATCH_STEP) {
+        setup.patch(patched);
+        for (int size = 1; size <= constants::MAX_GATES; size++) {
+            const std::vector<float> input = voltages(size);
+            setup.adapter.write(input.begin(), input.end());
+            // A patched port carries the elements after the previous patched port up to its own,
+            // at most size channels. Channels beyond the last element are 0V.
+            int from = 0;
+            for (int port = 0; port < constants::NUM_CHANNELS && from < size; port++) {
+                if (!isPatched(patched, port)) { continue; }
+                rack::engine::Output& output = setup.outx->outputs[port];
+                const int channels = std::min(port - from + 1, size);
+                CHECK(output.getChannels() == channels);
+                for (int c = 0; c < channels; c++) {
+                    CHECK(output.getVoltage(c) == (from + c < size ? input[from + c] : 0.F));
+                }
+                from = port + 1;
+            }
+        }
+    }
+}
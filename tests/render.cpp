@@ -0,0 +1,141 @@
+#include <rack.hpp>
+#include <string>
+#include <vector>
+#include "../src/InX.hpp"
+#include "../src/OutX.hpp"
+#include "../src/ReX.hpp"
+#include "../src/plugin.hpp"
+#include "harness.hpp"
+
+namespace {
+constexpr int ARR_PARAM_KNOB = 0;
+constexpr int ARR_INPUT_PATTERN = 0;
+constexpr int ARR_OUTPUT_MAIN = 0;
+constexpr int BANK_OUTPUT_MAIN = 0;
+constexpr int BANK_PARAM_BOOL = 0;
+
+/// @brief Sets the knobs of an Arr to 0V, 0.5V, 1V, ... as a patch would
+void loadRamp(rack::engine::Module* arr)
+{
+    json_t* rootJ = json_object();
+    for (int i = 0; i < constants::NUM_CHANNELS; i++) {
+        json_object_set_new(rootJ, ("knob" + std::to_string(i)).c_str(), json_real(i * 0.5));
+    }
+    arr->dataFromJson(rootJ);
+    json_decref(rootJ);
+}
+bool outputIsRamp(rack::engine::Module* arr, int start, int length)
+{
+    rack::engine::Output& output = arr->outputs[ARR_OUTPUT_MAIN];
+    if (output.getChannels() != length) { return false; }
+    for (int c = 0; c < length; c++) {
+        if (output.getVoltage(c) != ((start + c) % constants::NUM_CHANNELS) * 0.5F) {
+            return false;
+        }
+    }
+    return true;
+}
+}  // namespace
+
+TEST(arrRendersItsKnobs)
+{
+    harness::Row row;
+    rack::engine::Module* arr = row.add(modelArr);
+    loadRamp(arr);
+    row.patchOutput(arr, ARR_OUTPUT_MAIN);
+    row.step(4);
+    CHECK(outputIsRamp(arr, 0, constants::NUM_CHANNELS));
+}
+
+TEST(arrRendersThroughReX)
+{
+    harness::Row row;
+    auto* rex = row.add<ReX>(modelReX);
+    rack::engine::Module* arr = row.add(modelArr);
+    loadRamp(arr);
+    row.patchOutput(arr, ARR_OUTPUT_MAIN);
+    harness::Row::setParam(rex, ReX::PARAM_START, 3);
+    harness::Row::setParam(rex, ReX::PARAM_LENGTH, 5);
+    row.step(4);
+    CHECK(outputIsRamp(arr, 3, 5));
+
+    // A turned knob is picked up by the chain of the next sample
+    harness::Row::setParam(rex, ReX::PARAM_START, 14);
+    row.step();
+    CHECK(outputIsRamp(arr, 14, 5));
+
+    // Without Re^x the whole pattern is back
+    row.remove(rex);
+    row.step();
+    CHECK(outputIsRamp(arr, 0, constants::NUM_CHANNELS));
+}
+
+TEST(arrKnobsEditTheActivePattern)
+{
+    harness::Row row;
+    rack::engine::Module* arr = row.add(modelArr);
+    loadRamp(arr);
+    row.patchOutput(arr, ARR_OUTPUT_MAIN);
+    row.patchInput(arr, ARR_INPUT_PATTERN);
+    row.step(4);
+    CHECK(outputIsRamp(arr, 0, constants::NUM_CHANNELS));
+
+    // A turned knob is in the output of the next sample, without a UI
+    harness::Row::setParam(arr, ARR_PARAM_KNOB + 3, 7.F);
+    row.step();
+    rack::engine::Output& output = arr->outputs[ARR_OUTPUT_MAIN];
+    CHECK(output.getVoltage(3) == 7.F);
+    CHECK(output.getVoltage(4) == 2.F);
+
+    // Another pattern shows on the knobs, the edit stays with the first one
+    arr->inputs[ARR_INPUT_PATTERN].setVoltage(1.F);
+    row.step();
+    CHECK(output.getVoltage(3) == 0.F);
+    CHECK(arr->params[ARR_PARAM_KNOB + 3].getValue() == 0.F);
+    arr->inputs[ARR_INPUT_PATTERN].setVoltage(0.F);
+    row.step();
+    CHECK(output.getVoltage(3) == 7.F);
+    CHECK(arr->params[ARR_PARAM_KNOB + 3].getValue() == 7.F);
+}
+
+TEST(bankRendersGatesThroughItsChain)
+{
+    harness::Row row;
+    auto* rex = row.add<ReX>(modelReX);
+    auto* inx = row.add<InX>(modelInX);
+    rack::engine::Module* bank = row.add(modelBank);
+    auto* outx = row.add<OutX>(modelOutX);
+    row.patchOutput(bank, BANK_OUTPUT_MAIN);
+    std::vector<bool> gates;
+    for (int i = 0; i < constants::MAX_STEPS; i++) {
+        gates.push_back(((0b1011001110001101U >> i) & 1U) != 0);
+        harness::Row::setParam(bank, BANK_PARAM_BOOL + i, gates.back() ? 1.F : 0.F);
+    }
+    // In^x overwrites a gate with an off and another with an on
+    row.patchInput(inx, InX::INPUT_SIGNAL + 2);
+    inx->inputs[InX::INPUT_SIGNAL + 2].setVoltage(0.F);
+    row.patchInput(inx, InX::INPUT_SIGNAL + 5);
+    inx->inputs[InX::INPUT_SIGNAL + 5].setVoltage(10.F);
+    gates[2] = false;
+    gates[5] = true;
+    // Re^x then takes 8 gates from the fourth
+    harness::Row::setParam(rex, ReX::PARAM_START, 4);
+    harness::Row::setParam(rex, ReX::PARAM_LENGTH, 8);
+    gates = std::vector<bool>(gates.begin() + 4, gates.begin() + 12);
+    // Out^x cuts the gates of its individually patched ports, for gates that turns them off
+    harness::Row::setParam(outx, OutX::PARAM_NORMALLED, 0.F);
+    harness::Row::setParam(outx, OutX::PARAM_CUT, 1.F);
+    row.patchOutput(outx, OutX::OUTPUT_SIGNAL + 1);
+    row.patchOutput(outx, OutX::OUTPUT_SIGNAL + 6);
+    row.step();
+
+    CHECK(outx->outputs[OutX::OUTPUT_SIGNAL + 1].getVoltage() == (gates[1] ? 10.F : 0.F));
+    CHECK(outx->outputs[OutX::OUTPUT_SIGNAL + 6].getVoltage() == (gates[6] ? 10.F : 0.F));
+    gates[1] = false;
+    gates[6] = false;
+    rack::engine::Output& output = bank->outputs[BANK_OUTPUT_MAIN];
+    CHECK(output.getChannels() == static_cast<int>(gates.size()));
+    for (int c = 0; c < static_cast<int>(gates.size()); c++) {
+        CHECK(output.getVoltage(c) == (gates[c] ? 10.F : 0.F));
+    }
+}
@@ -0,0 +1,150 @@
+#include <vector>
+#include "../src/ReX.hpp"
+#include "../src/plugin.hpp"
+#include "harness.hpp"
+
+namespace {
+/// @brief Re^x copy: from start onwards, wrapping around
+/// @details A start beyond the end of the input starts at its beginning.
+template <typename T>
+std::vector<T> referenceCopy(const std::vector<T>& input, int start, int length)
+{
+    std::vector<T> output;
+    if (input.empty()) { return output; }
+    const int size = static_cast<int>(input.size());
+    if (start >= size) { start = 0; }
+    for (int i = 0; i < length; i++) {
+        output.push_back(input[(start + i) % size]);
+    }
+    return output;
+}
+/// @brief Re^x in place: the input rotated to start
+template <typename T>
+std::vector<T> referenceInPlace(const std::vector<T>& input, int start)
+{
+    return referenceCopy(input, start % static_cast<int>(input.size()),
+                         static_cast<int>(input.size()));
+}
+
+std::vector<float> voltages(int size)
+{
+    std::vector<float> input;
+    for (int i = 0; i < size; i++) {
+        input.push_back(static_cast<float>(i) + 0.25F);
+    }
+    return input;
+}
+std::vector<bool> gates(int size)
+{
+    std::vector<bool> input;
+    for (int i = 0; i < size; i++) {
+        input.push_back(((0b1001101011100010U >> i) & 1U) != 0);
+    }
+    return input;
+}
+
+/// @brief Runs input through adapter the way the chain does, in place when the adapter can
+template <typename T>
+std::vector<T> transform(const RexAdapter& adapter, std::vector<T> input, int channel = 0)
+{
+    const int size = static_cast<int>(input.size());
+    if (adapter.inPlace(size, channel)) {
+        adapter.transformInPlace(input.begin(), input.end(), channel);
+        return input;
+    }
+    std::vector<T> output(constants::MAX_GATES);
+    output.erase(adapter.transform(input.begin(), input.end(), output.begin(), channel),
+                 output.end());
+    return output;
+}
+/// @brief The copying transform, also for lengths the chain would transform in place
+template <typename T>
+std::vector<T> transformCopy(const RexAdapter& adapter, std::vector<T> input)
+{
+    std::vector<T> output(constants::MAX_GATES);
+    output.erase(adapter.transform(input.begin(), input.end(), output.begin(), 0), output.end());
+    return output;
+}
+}  // namespace
+
+TEST(rexCopiesEveryStartAndLength)
+{
+    harness::Row row;
+    auto* rex = row.add<ReX>(modelReX);
+    RexAdapter adapter;
+    adapter.setPtr(rex);
+    for (int size = 0; size <= constants::MAX_GATES; size++) {
+        for (int start = 0; start < constants::MAX_GATES; start++) {
+            for (int length = 1; length <= constants::MAX_GATES; length++) {
+                harness::Row::setParam(rex, ReX::PARAM_START, start);
+                harness::Row::setParam(rex, ReX::PARAM_LENGTH, length);
+                const int expected = size == 0 ? 0 : length;
+                CHECK(transformCopy(adapter, voltages(size)) ==
+                      referenceCopy(voltages(size), start, expected));
+                CHECK(transformCopy(adapter, gates(size)) ==
+                      referenceCopy(gates(size), start, expected));
+            }
+        }
+    }
+}
+
+TEST(rexTransformsInPlaceWhenTheLengthStays)
+{
+    harness::Row row;
+    auto* rex = row.add<ReX>(modelReX);
+    RexAdapter adapter;
+    adapter.setPtr(rex);
+    for (int size = 1; size <= constants::MAX_GATES; size++) {
+        for (int start = 0; start < constants::MAX_GATES; start++) {
+            harness::Row::setParam(rex, ReX::PARAM_START, start);
+            harness::Row::setParam(rex, ReX::PARAM_LENGTH, size);
+            CHECK(adapter.inPlace(size, 0));
+            CHECK(transform(adapter, voltages(size)) == referenceInPlace(voltages(size), start));
+            CHECK(transform(adapter, gates(size)) == referenceInPlace(gates(size), start));
+        }
+    }
+}
+
+TEST(rexAnswersQueriesLikeItTransforms)
+{
+    harness::Row row;
+    auto* rex = row.add<ReX>(modelReX);
+    RexAdapter adapter;
+    adapter.setPtr(rex);
+    for (int size = 1; size <= constants::MAX_GATES; size++) {
+        for (int start = 0; start < constants::MAX_GATES; start++) {
+            for (int length = 1; length <= constants::MAX_GATES; length++) {
+                harness::Row::setParam(rex, ReX::PARAM_START, start);
+                harness::Row::setParam(rex, ReX::PARAM_LENGTH, length);
+                const std::vector<float> output = transform(adapter, voltages(size));
+                CHECK(adapter.queryLength(size, 0) == static_cast<int>(output.size()));
+                for (int i = 0; i < static_cast<int>(output.size()); i++) {
+                    CHECK(voltages(size)[adapter.querySource(i, size, 0)] == output[i]);
+                }
+            }
+        }
+    }
+}
+
+TEST(rexFollowsTheCvOfEachChannel)
+{
+    harness::Row row;
+    auto* rex = row.add<ReX>(modelReX);
+    RexAdapter adapter;
+    adapter.setPtr(rex);
+    row.patchInput(rex, ReX::INPUT_START, constants::NUM_CHANNELS);
+    row.patchInput(rex, ReX::INPUT_LENGTH, constants::NUM_CHANNELS);
+    for (int channel = 0; channel < constants::NUM_CHANNELS; channel++) {
+        // 0V to 10V sweeps start over 0 to 16 and length over 1 to 17, both clamped
+        rex->inputs[ReX::INPUT_START].setVoltage(channel * 10.F / 16.F + 0.1F, channel);
+        rex->inputs[ReX::INPUT_LENGTH].setVoltage(channel * 10.F / 16.F + 0.1F, channel);
+    }
+    for (int channel = 0; channel < constants::NUM_CHANNELS; channel++) {
+        const std::vector<float> input = voltages(constants::MAX_GATES - 3);
+        const int length = channel + 1;
+        const std::vector<float> expected =
+            length == static_cast<int>(input.size()) ? referenceInPlace(input, channel)
+                                                     : referenceCopy(input, channel, length);
+        CHECK(transform(adapter, input, channel) == expected);
+    }
+}
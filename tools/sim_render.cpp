@@ -0,0 +1,650 @@
+/// @brief sim_render: runs a row of SIM modules offline, faster than real time
+/// @details The modules are the plugin's own, stepped by the engine stand-in of the tests (see
+/// tests/harness.hpp). Voltages for their inputs come from a CSV or WAV file and the outputs go
+/// to one, so a sequence can be pre-rendered or compared bit for bit with an earlier render.
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <rack.hpp>
+#include <string>
+#include <vector>
+#include "../tests/harness.hpp"
+
+namespace {
+const char* const USAGE = R"(Usage: sim_render [options] MODULE...
+Runs the SIM modules MODULE... side by side, from left to right, as fast as possible.
+
+  -i FILE          read the inputs from a .csv or .wav file
+  -I PORTS         the inputs fed by the channels of a .wav file, comma separated
+  -o FILE          write the outputs to a .csv or .wav file
+  -O PORTS         the outputs to write, comma separated
+  -c OUTPUT=INPUT  patch a cable from an output to an input, e.g. -c Arr.1=Phi.Poly
+  -p PARAM=VALUE   turn a knob before rendering, e.g. -p ReX.Start=3
+  -m MODULE=FILE   load a module preset (.vcvm) before rendering
+  -n FRAMES        frames to render, all frames of the input file by default
+  -r RATE          sample rate, 48000 by default
+  -b FRAMES        frames per block, 4096 by default
+
+MODULE is the slug of a model, like Phi or ReX, and MODULE#2 the second one of them.
+A port is MODULE.NAME[CHANNEL]: NAME is the name of the port as Rack shows it, without
+spaces, or its number from 1. CHANNEL counts from 1 as well and is 1 when left out, [1-4]
+is a range. Params are named the same way.
+The first row of a .csv file names the port of each column. In .wav files 10V is full
+scale; outputs are written as 32 bit float.
+Throughput is reported on stderr.
+)";
+
+/// @brief WAV files map 10V to full scale
+constexpr float WAV_VOLTS = 10.F;
+
+[[noreturn]] void fail(const std::string& message)
+{
+    std::fprintf(stderr, "sim_render: %s\n", message.c_str());
+    std::exit(1);
+}
+
+/// @brief Lower case without spaces or punctuation, the way ports and params are named here
+std::string normalize(const std::string& name)
+{
+    std::string normalized;
+    for (const char c : name) {
+        if (std::isalnum(static_cast<unsigned char>(c))) {
+            normalized += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+    }
+    return normalized;
+}
+
+std::vector<std::string> split(const std::string& text, char separator)
+{
+    std::vector<std::string> parts;
+    size_t from = 0;
+    while (true) {
+        const size_t to = text.find(separator, from);
+        parts.push_back(text.substr(from, to - from));
+        if (to == std::string::npos) { return parts; }
+        from = to + 1;
+    }
+}
+
+int parseInt(const std::string& text, const std::string& what)
+{
+    char* end = nullptr;
+    const long value = std::strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0') { fail("bad " + what + ": " + text); }
+    return static_cast<int>(value);
+}
+
+/// @brief The modules of the row, looked up by slug
+class Modules {
+   public:
+    Modules(harness::Row& row, const std::vector<std::string>& slugs)
+    {
+        // Never deleted, Rack's Plugin deletes its models and the modules of the row use them
+        auto* plugin = new rack::plugin::Plugin;
+        init(plugin);
+        for (const std::string& slug : slugs) {
+            auto model = std::find_if(plugin->models.begin(), plugin->models.end(),
+                                      [&slug](const auto* model) { return model->slug == slug; });
+            if (model == plugin->models.end()) { fail("no module " + slug); }
+            modules.push_back(row.add(*model));
+        }
+    }
+    /// @brief The module for MODULE or MODULE#n
+    rack::engine::Module* find(const std::string& name) const
+    {
+        const size_t hash = name.find('#');
+        const std::string slug = name.substr(0, hash);
+        int nth = hash == std::string::npos ? 1 : parseInt(name.substr(hash + 1), "module");
+        for (rack::engine::Module* module : modules) {
+            if (module->model->slug == slug && --nth == 0) { return module; }
+        }
+        fail("no module " + name + " in the row");
+    }
+
+   private:
+    std::vector<rack::engine::Module*> modules;
+};
+
+/// @brief A channel of a port, a column of the input or output file
+struct Channel {
+    rack::engine::Module* module;
+    int portId;
+    int channel;
+    /// @brief MODULE.NAME[CHANNEL]
+    std::string name;
+};
+
+/// @brief Parses MODULE.NAME[CHANNEL] or MODULE.NAME[FROM-TO], for an input or an output
+std::vector<Channel> parsePort(const Modules& modules, const std::string& spec, bool input)
+{
+    const size_t dot = spec.find('.');
+    if (dot == std::string::npos) { fail("bad port " + spec); }
+    rack::engine::Module* module = modules.find(spec.substr(0, dot));
+    std::string name = spec.substr(dot + 1);
+    int from = 1;
+    int to = 1;
+    const size_t bracket = name.find('[');
+    if (bracket != std::string::npos) {
+        if (name.back() != ']') { fail("bad port " + spec); }
+        const std::vector<std::string> range =
+            split(name.substr(bracket + 1, name.size() - bracket - 2), '-');
+        from = parseInt(range.front(), "channel");
+        to = parseInt(range.back(), "channel");
+        name.resize(bracket);
+        if (range.size() > 2 || from < 1 || to < from || to > rack::PORT_MAX_CHANNELS) {
+            fail("bad channels in " + spec);
+        }
+    }
+    const std::vector<rack::engine::PortInfo*>& infos =
+        input ? module->inputInfos : module->outputInfos;
+    int portId = -1;
+    for (int id = 0; id < static_cast<int>(infos.size()); id++) {
+        if (normalize(infos[id]->name) == normalize(name) || std::to_string(id + 1) == name) {
+            portId = id;
+            break;
+        }
+    }
+    if (portId < 0) { fail(std::string("no ") + (input ? "input " : "output ") + spec); }
+    std::vector<Channel> channels;
+    for (int channel = from; channel <= to; channel++) {
+        const std::string channelName = name + "[" + std::to_string(channel) + "]";
+        channels.push_back({module, portId, channel - 1, spec.substr(0, dot + 1) + channelName});
+    }
+    return channels;
+}
+
+std::vector<Channel> parsePorts(const Modules& modules,
+                                const std::vector<std::string>& specs,
+                                bool input)
+{
+    std::vector<Channel> channels;
+    for (const std::string& spec : specs) {
+        if (spec.empty()) { continue; }
+        const std::vector<Channel> port = parsePort(modules, spec, input);
+        channels.insert(channels.end(), port.begin(), port.end());
+    }
+    return channels;
+}
+
+/// @brief Interleaved frames of a .csv or .wav file, a column per channel of a port
+class Reader {
+   public:
+    virtual ~Reader() = default;
+    /// @brief Reads up to frames frames, returns the number read
+    virtual int read(float* samples, int frames) = 0;
+    /// @brief The port of every column, as named in the file. Empty for .wav files.
+    const std::vector<std::string>& getHeader() const
+    {
+        return header;
+    }
+    int getColumns() const
+    {
+        return columns;
+    }
+
+   protected:
+    std::vector<std::string> header;
+    int columns = 0;
+};
+
+class Writer {
+   public:
+    virtual ~Writer() = default;
+    virtual void write(const float* samples, int frames) = 0;
+};
+
+class CsvReader : public Reader {
+   public:
+    explicit CsvReader(FILE* file) : file(file)
+    {
+        std::string line;
+        if (!readLine(line)) { fail("empty input file"); }
+        header = split(line, ',');
+        columns = static_cast<int>(header.size());
+    }
+    ~CsvReader() override
+    {
+        std::fclose(file);
+    }
+    int read(float* samples, int frames) override
+    {
+        std::string line;
+        int frame = 0;
+        for (; frame < frames && readLine(line); frame++) {
+            const std::vector<std::string> values = split(line, ',');
+            if (static_cast<int>(values.size()) != columns) {
+                fail("expected " + std::to_string(columns) + " values: " + line);
+            }
+            for (int column = 0; column < columns; column++) {
+                samples[frame * columns + column] = std::strtof(values[column].c_str(), nullptr);
+            }
+        }
+        return frame;
+    }
+
+   private:
+    FILE* file;
+
+    /// @brief The next line that isn't empty, without spaces
+    bool readLine(std::string& line)
+    {
+        line.clear();
+        int c = 0;
+        while ((c = std::fgetc(file)) != EOF) {
+            if (c == '\n') {
+                if (line.empty()) { continue; }
+                return true;
+            }
+            if (!std::isspace(c)) { line += static_cast<char>(c); }
+        }
+        return !line.empty();
+    }
+};
+
+class CsvWriter : public Writer {
+   public:
+    CsvWriter(FILE* file, const std::vector<std::string>& header) : file(file)
+    {
+        columns = static_cast<int>(header.size());
+        for (int column = 0; column < columns; column++) {
+            std::fprintf(file, "%s%s", column ? "," : "", header[column].c_str());
+        }
+        std::fputc('\n', file);
+    }
+    ~CsvWriter() override
+    {
+        std::fclose(file);
+    }
+    void write(const float* samples, int frames) override
+    {
+        // 9 significant digits read back as the same float
+        for (int frame = 0; frame < frames; frame++) {
+            for (int column = 0; column < columns; column++) {
+                std::fprintf(file, "%s%.9g", column ? "," : "",
+                             samples[frame * columns + column]);
+            }
+            std::fputc('\n', file);
+        }
+    }
+
+   private:
+    FILE* file;
+    int columns;
+};
+
+uint32_t littleEndian(const uint8_t* bytes, int count)
+{
+    uint32_t value = 0;
+    for (int i = count - 1; i >= 0; i--) {
+        value = (value << 8U) | bytes[i];
+    }
+    return value;
+}
+
+class WavReader : public Reader {
+   public:
+    explicit WavReader(FILE* file) : file(file)
+    {
+        uint8_t riff[12];
+        if (std::fread(riff, 1, 12, file) != 12 || std::memcmp(riff, "RIFF", 4) != 0 ||
+            std::memcmp(riff + 8, "WAVE", 4) != 0) {
+            fail("not a WAV file");
+        }
+        uint8_t chunk[8];
+        while (std::fread(chunk, 1, 8, file) == 8) {
+            const uint32_t size = littleEndian(chunk + 4, 4);
+            if (std::memcmp(chunk, "data", 4) == 0) {
+                if (bytesPerSample == 0) { fail("WAV file without format"); }
+                remaining = size / (bytesPerSample * columns);
+                return;
+            }
+            std::vector<uint8_t> body(size + (size & 1U));
+            if (std::fread(body.data(), 1, body.size(), file) != body.size()) { break; }
+            if (std::memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+                int format = static_cast<int>(littleEndian(body.data(), 2));
+                // WAVE_FORMAT_EXTENSIBLE keeps the format in its sub format
+                if (format == 0xFFFE && size >= 26) {
+                    format = static_cast<int>(littleEndian(body.data() + 24, 2));
+                }
+                columns = static_cast<int>(littleEndian(body.data() + 2, 2));
+                const int bits = static_cast<int>(littleEndian(body.data() + 14, 2));
+                isFloat = format == 3;
+                if (!(format == 1 && (bits == 16 || bits == 24 || bits == 32)) &&
+                    !(isFloat && bits == 32)) {
+                    fail("WAV files must be 16, 24 or 32 bit PCM or 32 bit float");
+                }
+                bytesPerSample = bits / 8;
+            }
+        }
+        fail("WAV file without data");
+    }
+    ~WavReader() override
+    {
+        std::fclose(file);
+    }
+    int read(float* samples, int frames) override
+    {
+        frames = static_cast<int>(std::min<uint32_t>(frames, remaining));
+        std::vector<uint8_t> bytes(static_cast<size_t>(frames) * columns * bytesPerSample);
+        frames = static_cast<int>(std::fread(bytes.data(), 1, bytes.size(), file) /
+                                  (columns * bytesPerSample));
+        remaining -= frames;
+        for (int i = 0; i < frames * columns; i++) {
+            const uint32_t raw = littleEndian(bytes.data() + i * bytesPerSample, bytesPerSample);
+            float sample = 0.F;
+            if (isFloat) { std::memcpy(&sample, &raw, sizeof sample); }
+            else {
+                // Sign extended from the top bit of the sample
+                const int shift = 32 - bytesPerSample * 8;
+                sample = static_cast<float>(static_cast<int32_t>(raw << shift)) / 2147483648.F;
+            }
+            samples[i] = sample * WAV_VOLTS;
+        }
+        return frames;
+    }
+
+   private:
+    FILE* file;
+    bool isFloat = false;
+    int bytesPerSample = 0;
+    uint32_t remaining = 0;
+};
+
+class WavWriter : public Writer {
+   public:
+    WavWriter(FILE* file, int columns, int sampleRate) : file(file), columns(columns)
+    {
+        uint8_t header[44] = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E', 'f', 'm', 't',
+                              ' ', 16, 0, 0, 0, 3, 0};
+        put(header + 22, columns, 2);
+        put(header + 24, sampleRate, 4);
+        put(header + 28, sampleRate * columns * 4, 4);
+        put(header + 32, columns * 4, 2);
+        put(header + 34, 32, 2);
+        std::memcpy(header + 36, "data", 4);
+        std::fwrite(header, 1, sizeof header, file);
+    }
+    ~WavWriter() override
+    {
+        // The sizes are known at the end only
+        uint8_t size[4];
+        put(size, 36 + dataSize, 4);
+        std::fseek(file, 4, SEEK_SET);
+        std::fwrite(size, 1, 4, file);
+        put(size, dataSize, 4);
+        std::fseek(file, 40, SEEK_SET);
+        std::fwrite(size, 1, 4, file);
+        std::fclose(file);
+    }
+    void write(const float* samples, int frames) override
+    {
+        std::vector<uint8_t> bytes(static_cast<size_t>(frames) * columns * 4);
+        for (int i = 0; i < frames * columns; i++) {
+            const float sample = samples[i] / WAV_VOLTS;
+            uint32_t raw = 0;
+            std::memcpy(&raw, &sample, sizeof raw);
+            put(bytes.data() + i * 4, raw, 4);
+        }
+        std::fwrite(bytes.data(), 1, bytes.size(), file);
+        dataSize += static_cast<uint32_t>(bytes.size());
+    }
+
+   private:
+    FILE* file;
+    int columns;
+    uint32_t dataSize = 0;
+
+    static void put(uint8_t* bytes, uint32_t value, int count)
+    {
+        for (int i = 0; i < count; i++) {
+            bytes[i] = (value >> (8U * i)) & 0xFFU;
+        }
+    }
+};
+
+/// @brief A cable between two ports of the row
+/// @details Stepped before the modules as Rack's engine does, so it delays by a sample.
+struct Cable {
+    rack::engine::Output* output;
+    rack::engine::Input* input;
+
+    /// @brief Cable_step() of Rack's engine
+    void step() const
+    {
+        const int channels = output->getChannels();
+        std::copy_n(output->voltages, channels, input->voltages);
+        for (int c = channels; c < input->getChannels(); c++) {
+            input->voltages[c] = 0.F;
+        }
+        input->channels = channels;
+    }
+};
+
+Cable patchCable(harness::Row& row, const Modules& modules, const std::string& cable)
+{
+    const size_t equals = cable.find('=');
+    if (equals == std::string::npos) { fail("bad cable " + cable); }
+    const Channel from = parsePort(modules, cable.substr(0, equals), false).front();
+    const Channel to = parsePort(modules, cable.substr(equals + 1), true).front();
+    // Rack gives an output its first channel when the first cable is patched into it
+    rack::engine::Output& output = from.module->outputs[from.portId];
+    row.patchOutput(from.module, from.portId);
+    row.patchInput(to.module, to.portId, std::max(output.getChannels(), 1));
+    return {&output, &to.module->inputs[to.portId]};
+}
+
+bool isWav(const std::string& path)
+{
+    return path.size() > 4 && normalize(path.substr(path.size() - 4)) == "wav";
+}
+
+FILE* open(const std::string& path, const char* mode)
+{
+    FILE* file = std::fopen(path.c_str(), mode);
+    if (!file) { fail("can't open " + path); }
+    return file;
+}
+
+/// @brief Sets the params and the data of a .vcvm module preset, as loading it in Rack does
+void loadPreset(rack::engine::Module* module, const std::string& path)
+{
+    json_error_t error;
+    json_t* rootJ = json_load_file(path.c_str(), 0, &error);
+    if (!rootJ) { fail("can't read " + path + ": " + error.text); }
+    json_t* paramsJ = json_object_get(rootJ, "params");
+    for (size_t i = 0; i < json_array_size(paramsJ); i++) {
+        json_t* paramJ = json_array_get(paramsJ, i);
+        json_t* idJ = json_object_get(paramJ, "id");
+        json_t* valueJ = json_object_get(paramJ, "value");
+        const int id = idJ ? static_cast<int>(json_integer_value(idJ)) : static_cast<int>(i);
+        if (valueJ && id >= 0 && id < static_cast<int>(module->params.size())) {
+            harness::Row::setParam(module, id, static_cast<float>(json_number_value(valueJ)));
+        }
+    }
+    json_t* dataJ = json_object_get(rootJ, "data");
+    if (dataJ) { module->dataFromJson(dataJ); }
+    json_decref(rootJ);
+}
+
+/// @brief Turns the knob of MODULE.NAME=VALUE
+void setParam(const Modules& modules, const std::string& assignment)
+{
+    const size_t dot = assignment.find('.');
+    const size_t equals = assignment.find('=');
+    if (dot == std::string::npos || equals == std::string::npos || equals < dot) {
+        fail("bad param " + assignment);
+    }
+    rack::engine::Module* module = modules.find(assignment.substr(0, dot));
+    const std::string name = assignment.substr(dot + 1, equals - dot - 1);
+    for (int id = 0; id < static_cast<int>(module->paramQuantities.size()); id++) {
+        if (normalize(module->paramQuantities[id]->name) == normalize(name) ||
+            std::to_string(id + 1) == name) {
+            const float value = std::strtof(assignment.c_str() + equals + 1, nullptr);
+            harness::Row::setParam(module, id, value);
+            return;
+        }
+    }
+    fail("no param " + assignment.substr(0, equals));
+}
+
+struct Options {
+    std::string inputPath;
+    std::string outputPath;
+    std::vector<std::string> inputPorts;
+    std::vector<std::string> outputPorts;
+    std::vector<std::string> cables;
+    std::vector<std::string> params;
+    std::vector<std::string> presets;
+    std::vector<std::string> slugs;
+    long long frames = -1;
+    int sampleRate = 48000;
+    int blockFrames = 4096;
+};
+
+Options parseOptions(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg.size() != 2 || arg[0] != '-') {
+            options.slugs.push_back(arg);
+            continue;
+        }
+        if (arg == "-h") {
+            std::fputs(USAGE, stdout);
+            std::exit(0);
+        }
+        if (i + 1 == argc) { fail("missing value for " + arg); }
+        const std::string value = argv[++i];
+        switch (arg[1]) {
+            case 'i': options.inputPath = value; break;
+            case 'o': options.outputPath = value; break;
+            case 'I': options.inputPorts = split(value, ','); break;
+            case 'O': options.outputPorts = split(value, ','); break;
+            case 'c': options.cables.push_back(value); break;
+            case 'p': options.params.push_back(value); break;
+            case 'm': options.presets.push_back(value); break;
+            case 'n': options.frames = parseInt(value, "frames"); break;
+            case 'r': options.sampleRate = parseInt(value, "sample rate"); break;
+            case 'b': options.blockFrames = parseInt(value, "block size"); break;
+            default: fail("unknown option " + arg);
+        }
+    }
+    if (options.slugs.empty()) {
+        std::fputs(USAGE, stderr);
+        std::exit(1);
+    }
+    if (options.inputPath.empty() && options.frames < 0) { fail("-n is needed without -i"); }
+    if (!options.outputPath.empty() && options.outputPorts.empty()) { fail("-o needs -O"); }
+    if (options.sampleRate <= 0 || options.blockFrames <= 0) { fail("bad rate or block size"); }
+    return options;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    const Options options = parseOptions(argc, argv);
+    const harness::Context context(static_cast<float>(options.sampleRate));
+    harness::Row row;
+    const Modules modules(row, options.slugs);
+    for (const std::string& preset : options.presets) {
+        const size_t equals = preset.find('=');
+        if (equals == std::string::npos) { fail("bad preset " + preset); }
+        loadPreset(modules.find(preset.substr(0, equals)), preset.substr(equals + 1));
+    }
+    for (const std::string& param : options.params) {
+        setParam(modules, param);
+    }
+
+    std::unique_ptr<Reader> reader;
+    std::vector<Channel> inputs;
+    if (!options.inputPath.empty()) {
+        if (isWav(options.inputPath)) {
+            reader = std::make_unique<WavReader>(open(options.inputPath, "rb"));
+            inputs = parsePorts(modules, options.inputPorts, true);
+        }
+        else {
+            reader = std::make_unique<CsvReader>(open(options.inputPath, "r"));
+            inputs = parsePorts(modules, reader->getHeader(), true);
+        }
+        if (static_cast<int>(inputs.size()) != reader->getColumns()) {
+            fail("the input file has " + std::to_string(reader->getColumns()) + " channels for " +
+                 std::to_string(inputs.size()) + " inputs");
+        }
+    }
+    // A port gets as many channels as the highest channel the file has for it
+    for (const Channel& input : inputs) {
+        rack::engine::Input& port = input.module->inputs[input.portId];
+        row.patchInput(input.module, input.portId, std::max<int>(port.channels, input.channel + 1));
+    }
+    const std::vector<Channel> outputs = parsePorts(modules, options.outputPorts, false);
+    for (const Channel& output : outputs) {
+        row.patchOutput(output.module, output.portId);
+    }
+    std::vector<Cable> cables;
+    for (const std::string& cable : options.cables) {
+        cables.push_back(patchCable(row, modules, cable));
+    }
+
+    std::unique_ptr<Writer> writer;
+    if (!options.outputPath.empty()) {
+        if (isWav(options.outputPath)) {
+            writer = std::make_unique<WavWriter>(open(options.outputPath, "wb"),
+                                                 static_cast<int>(outputs.size()),
+                                                 options.sampleRate);
+        }
+        else {
+            std::vector<std::string> header;
+            for (const Channel& output : outputs) {
+                header.push_back(output.name);
+            }
+            writer = std::make_unique<CsvWriter>(open(options.outputPath, "w"), header);
+        }
+    }
+
+    const int block = options.blockFrames;
+    std::vector<float> inputBlock(static_cast<size_t>(block) * inputs.size());
+    std::vector<float> outputBlock(static_cast<size_t>(block) * outputs.size());
+    long long rendered = 0;
+    std::chrono::steady_clock::duration stepping{};
+    while (options.frames < 0 || rendered < options.frames) {
+        int frames = block;
+        if (options.frames >= 0) {
+            frames = static_cast<int>(std::min<long long>(frames, options.frames - rendered));
+        }
+        if (reader) { frames = reader->read(inputBlock.data(), frames); }
+        if (frames == 0) { break; }
+        const auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++) {
+            const float* in = inputBlock.data() + frame * inputs.size();
+            for (size_t i = 0; i < inputs.size(); i++) {
+                inputs[i].module->inputs[inputs[i].portId].setVoltage(in[i], inputs[i].channel);
+            }
+            for (const Cable& cable : cables) {
+                cable.step();
+            }
+            row.step();
+            float* out = outputBlock.data() + frame * outputs.size();
+            for (size_t i = 0; i < outputs.size(); i++) {
+                rack::engine::Output& port = outputs[i].module->outputs[outputs[i].portId];
+                const int channel = outputs[i].channel;
+                out[i] = channel < port.getChannels() ? port.getVoltage(channel) : 0.F;
+            }
+        }
+        stepping += std::chrono::steady_clock::now() - start;
+        if (writer) { writer->write(outputBlock.data(), frames); }
+        rendered += frames;
+    }
+
+    const double seconds = std::chrono::duration<double>(stepping).count();
+    std::fprintf(stderr, "sim_render: %lld frames in %.3f s, %.0f frames/s, %.1fx real time\n",
+                 rendered, seconds, seconds > 0 ? rendered / seconds : 0.,
+                 seconds > 0 ? rendered / seconds / options.sampleRate : 0.);
+    return 0;
+}